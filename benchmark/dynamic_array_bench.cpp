@@ -1,10 +1,13 @@
 #include <benchmark/benchmark.h>
 #include <omp.h>
 
+#include <cstdint>
 #include <cstdlib>
 #include <vector>
 
+#include "helper_cpu_bench.hpp"
 #include "parstd/internal/cpu_vector.hpp"
+#include "parstd/vector.hpp"
 
 volatile size_t num_dbl_elements = 1024 * 1024 * 128;
 
@@ -54,8 +57,103 @@ BENCHMARK(DynArr_CreateArrayOmpValue)->Unit(benchmark::kMillisecond);
 
 static void DynArr_ResizeArray(benchmark::State& state) {
   for (auto _ : state) {
-    CpuStdVector<double> d(num_dbl_elements, 1.734);
+    CpuStdVector<double> d;
+    d.resize(num_dbl_elements);
     benchmark::DoNotOptimize(d);
   }
 }
-BENCHMARK(DynArr_CreateArrayValue)->Unit(benchmark::kMillisecond);
+BENCHMARK(DynArr_ResizeArray)->Unit(benchmark::kMillisecond);
+
+// The GpuVector benchmarks measure the allocation policy of the NumaAllocator:
+// no fill on resize, parallel first touch and huge pages. The first argument
+// switches the huge pages off (0) or on (1).
+
+class HugePagesGuard {
+ public:
+  HugePagesGuard(const bool huge_pages) : prev_(GetHugePages()) {
+    SetHugePages(huge_pages);
+  }
+  ~HugePagesGuard() { SetHugePages(prev_); }
+
+ private:
+  bool prev_;
+};
+
+static void HugePagesOffOn(benchmark::internal::Benchmark* b) {
+  b->Arg(0)->Arg(1);
+}
+
+static void DynArr_CreateGpuVector(benchmark::State& state) {
+  HugePagesGuard huge_pages(state.range(0));
+  for (auto _ : state) {
+    GpuVector<double> d(num_dbl_elements);
+    benchmark::DoNotOptimize(d.data());
+  }
+}
+BENCHMARK(DynArr_CreateGpuVector)
+    ->Apply(HugePagesOffOn)
+    ->Unit(benchmark::kMillisecond);
+
+// the pattern of Derivative::Resize followed by the rhs kernel
+static void DynArr_ResizeWriteGpuVector(benchmark::State& state) {
+  HugePagesGuard huge_pages(state.range(0));
+  for (auto _ : state) {
+    GpuVector<double> d;
+    d.resize(num_dbl_elements);
+#pragma omp parallel for schedule(static)
+    for (size_t i = 0; i < d.size(); ++i) {
+      d[i] = 1.734;
+    }
+    benchmark::DoNotOptimize(d.data());
+  }
+}
+BENCHMARK(DynArr_ResizeWriteGpuVector)
+    ->Apply(HugePagesOffOn)
+    ->Unit(benchmark::kMillisecond);
+
+static void DynArr_ResizeWriteStdVector(benchmark::State& state) {
+  for (auto _ : state) {
+    std::vector<double> d;
+    d.resize(num_dbl_elements);
+#pragma omp parallel for schedule(static)
+    for (size_t i = 0; i < d.size(); ++i) {
+      d[i] = 1.734;
+    }
+    benchmark::DoNotOptimize(d.data());
+  }
+}
+BENCHMARK(DynArr_ResizeWriteStdVector)->Unit(benchmark::kMillisecond);
+
+// Random reads like the neighbor loops, dominated by TLB misses with 4kB
+// pages once the array is much larger than the TLB reach.
+constexpr size_t num_gather_reads = 1 << 24;
+
+template <typename Vector>
+static void Gather(benchmark::State& state, const Vector& d) {
+  const std::vector<uint64_t> idx =
+      RandomStdVector<uint64_t>(num_gather_reads, 0, d.size() - 1);
+  for (auto _ : state) {
+    double sum = 0.;
+#pragma omp parallel for schedule(static) reduction(+ : sum)
+    for (size_t i = 0; i < idx.size(); ++i) {
+      sum += d[idx[i]];
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * idx.size());
+}
+
+static void DynArr_GatherGpuVector(benchmark::State& state) {
+  HugePagesGuard huge_pages(state.range(0));
+  const GpuVector<double> d(num_dbl_elements, 1.734);
+  Gather(state, d);
+}
+BENCHMARK(DynArr_GatherGpuVector)
+    ->Apply(HugePagesOffOn)
+    ->Unit(benchmark::kMillisecond);
+
+static void DynArr_GatherStdVector(benchmark::State& state) {
+  const std::vector<double> d(num_dbl_elements, 1.734);
+  Gather(state, d);
+}
+BENCHMARK(DynArr_GatherStdVector)->Unit(benchmark::kMillisecond);
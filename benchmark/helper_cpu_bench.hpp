@@ -1,5 +1,8 @@
 #pragma once
 
+#include <benchmark/benchmark.h>
+#include <omp.h>
+
 #include <tuple>
 #include <vector>
 
@@ -7,6 +10,25 @@
 #include "utils/random.hpp"
 #include "utils/types.hpp"
 
+// powers of two up to the maximum number of OpenMP threads
+inline void ThreadCounts(benchmark::internal::Benchmark* b) {
+  for (int nt = 1; nt < omp_get_max_threads(); nt *= 2) {
+    b->Arg(nt);
+  }
+  b->Arg(omp_get_max_threads());
+}
+
+class OmpThreadsGuard {
+ public:
+  OmpThreadsGuard(const int num_threads) : prev_(omp_get_max_threads()) {
+    omp_set_num_threads(num_threads);
+  }
+  ~OmpThreadsGuard() { omp_set_num_threads(prev_); }
+
+ private:
+  int prev_;
+};
+
 template <typename T>
 std::vector<T> RandomStdVector(const size_t n = 8'000'000, const T min_v = 0,
                                const T max_v = static_cast<T>(35314590)) {
@@ -5,6 +5,7 @@
 #include "algo/morton_octree.hpp"
 #include "algo/morton_points.hpp"
 #include "helper_cpu_bench.hpp"
+#include "neighbor/point_cell_list.hpp"
 #include "parstd/parstd.hpp"
 
 static void Morton64PointsCreate(benchmark::State& state) {
@@ -36,6 +37,7 @@ static void Morton64OctreeCreate(benchmark::State& state) {
   for (auto _ : state) {
     MortonOctree<Morton64> octree(morton_points.cell_mortons());
     benchmark::DoNotOptimize(octree);
+    GetStepArena().Reset();
   }
 }
 BENCHMARK(Morton64OctreeCreate)->Unit(benchmark::kMillisecond);
@@ -47,6 +49,33 @@ static void Morton32OctreeCreate(benchmark::State& state) {
   for (auto _ : state) {
     MortonOctree<Morton32> octree(morton_points.cell_mortons());
     benchmark::DoNotOptimize(octree);
+    GetStepArena().Reset();
   }
 }
-BENCHMARK(Morton32OctreeCreate)->Unit(benchmark::kMillisecond);
\ No newline at end of file
+BENCHMARK(Morton32OctreeCreate)->Unit(benchmark::kMillisecond);
+// A new cell list per step against the update in place, which takes its
+// temporaries from the StepArena and keeps the memory of the list.
+static void PointCellListCreate(benchmark::State& state) {
+  auto [dr, init_points] = CreatePointCuboid(8'000'000, 1.0);
+  const GpuVector<Vectord> points = init_points;
+  for (auto _ : state) {
+    auto [index_map, cell_list] = PointCellListD::Create(2. * 1.2 * dr, points);
+    benchmark::DoNotOptimize(cell_list);
+    GetStepArena().Reset();
+  }
+  state.counters["arena_high_water_mb"] = GetStepArena().HighWaterMark() / 1e6;
+}
+BENCHMARK(PointCellListCreate)->Unit(benchmark::kMillisecond);
+
+static void PointCellListUpdate(benchmark::State& state) {
+  auto [dr, init_points] = CreatePointCuboid(8'000'000, 1.0);
+  PointCellListD cell_list =
+      std::get<1>(PointCellListD::Create(2. * 1.2 * dr, init_points));
+  for (auto _ : state) {
+    const auto index_map = cell_list.Update();
+    benchmark::DoNotOptimize(index_map.data());
+    GetStepArena().Reset();
+  }
+  state.counters["arena_high_water_mb"] = GetStepArena().HighWaterMark() / 1e6;
+}
+BENCHMARK(PointCellListUpdate)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,90 @@
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <cstdint>
+#include <tuple>
+
+#include "helper_cpu_bench.hpp"
+#include "neighbor/saved_neighbors.hpp"
+#include "parstd/parallel_for.hpp"
+#include "preprocess/point_shapes.hpp"
+
+// Compares the work-stealing scheduler of ParallelFor against OpenMP's guided
+// and dynamic schedules. The argument is the Schedule. Besides the time, the
+// imbalance (max over mean busy time) and the number of steals are reported.
+
+static void Schedules(benchmark::internal::Benchmark* b) {
+  b->ArgName("schedule");
+  for (const Schedule s :
+       {Schedule::kWorkStealing, Schedule::kGuided, Schedule::kDynamic}) {
+    b->Arg(static_cast<int>(s));
+  }
+}
+
+class ScheduleGuard {
+ public:
+  ScheduleGuard(const Schedule schedule) : prev_(GetParallelForSchedule()) {
+    SetParallelForSchedule(schedule);
+  }
+  ~ScheduleGuard() { SetParallelForSchedule(prev_); }
+
+ private:
+  Schedule prev_;
+};
+
+static void AddStats(benchmark::State& state, const ParallelForStats& stats) {
+  state.counters["imbalance"] = stats.Imbalance();
+  state.counters["steals"] = stats.TotalSteals();
+}
+
+// the last tenth of the indices is a hundred times as expensive, like the
+// cells of a dense pool sorted behind the cells of a sparse spray
+static void ParallelFor_Skewed(benchmark::State& state) {
+  ScheduleGuard guard(static_cast<Schedule>(state.range(0)));
+  constexpr size_t n = 1 << 16;
+  std::vector<double> res(n);
+  ParallelForStats stats;
+  const auto work = [&](const size_t i) {
+    const size_t iterations = (i < n - n / 10) ? 10 : 1000;
+    double acc = i;
+    for (size_t k = 0; k < iterations; ++k) {
+      acc = std::sqrt(acc + k);
+    }
+    res[i] = acc;
+  };
+  for (auto _ : state) {
+    ParallelFor(IndexRange<size_t>(n), 4, work, &stats);
+    benchmark::DoNotOptimize(res.data());
+  }
+  // of the last iteration
+  AddStats(state, stats);
+}
+BENCHMARK(ParallelFor_Skewed)->Apply(Schedules);
+
+// a dense pool with a sparse spray of droplets above it
+static std::vector<Vectord> PoolWithSpray(const double dr) {
+  std::vector<Vectord> res =
+      PointDiscretize::Cube(dr, Vectord(1., 1., 0.3), Vectord(0.));
+  const auto spray =
+      RandomStdVectorVectorNT<3, double>(res.size() / 20, 0., 1.);
+  for (const auto& s : spray) {
+    res.push_back(Vectord(s[0], s[1], 0.4 + 2. * s[2]));
+  }
+  return res;
+}
+
+static void ParallelFor_SavedNeighbors(benchmark::State& state) {
+  ScheduleGuard guard(static_cast<Schedule>(state.range(0)));
+  const double dr = 0.02;
+  const PointCellListD cell_list =
+      std::get<1>(PointCellListD::Create(2. * dr, PoolWithSpray(dr)));
+  SavedNeighborsD neighbors(cell_list);
+  for (auto _ : state) {
+    neighbors.Update(cell_list);
+    benchmark::DoNotOptimize(neighbors.size());
+  }
+  state.SetItemsProcessed(state.iterations() * cell_list.size());
+}
+BENCHMARK(ParallelFor_SavedNeighbors)
+    ->Apply(Schedules)
+    ->Unit(benchmark::kMillisecond);
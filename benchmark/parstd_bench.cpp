@@ -0,0 +1,147 @@
+#include <benchmark/benchmark.h>
+#include <omp.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <execution>
+#include <numeric>
+
+#include "helper_cpu_bench.hpp"
+#include "parstd/parstd.hpp"
+
+// Compares the parstd algorithms against the std::execution::par_unseq
+// overloads. The first argument of the parstd benchmarks is the number of
+// OpenMP threads, so the scaling can be read off directly.
+
+constexpr size_t num_bench_elements = 16'000'000;
+
+static void ParStd_Sort(benchmark::State& state) {
+  OmpThreadsGuard threads(state.range(0));
+  const GpuVector<uint64_t> init =
+      RandomStdVector<uint64_t>(num_bench_elements);
+  for (auto _ : state) {
+    state.PauseTiming();
+    GpuVector<uint64_t> v = init;
+    state.ResumeTiming();
+    Sort(v);
+    benchmark::DoNotOptimize(v.data());
+  }
+}
+BENCHMARK(ParStd_Sort)->Apply(ThreadCounts)->Unit(benchmark::kMillisecond);
+
+static void StdParUnseq_Sort(benchmark::State& state) {
+  const std::vector<uint64_t> init =
+      RandomStdVector<uint64_t>(num_bench_elements);
+  for (auto _ : state) {
+    state.PauseTiming();
+    std::vector<uint64_t> v = init;
+    state.ResumeTiming();
+    std::sort(std::execution::par_unseq, v.begin(), v.end());
+    benchmark::DoNotOptimize(v.data());
+  }
+}
+BENCHMARK(StdParUnseq_Sort)->Unit(benchmark::kMillisecond);
+
+static void ParStd_Unique(benchmark::State& state) {
+  OmpThreadsGuard threads(state.range(0));
+  GpuVector<uint64_t> init =
+      RandomDuplicateStdVector<uint64_t>(num_bench_elements);
+  std::sort(init.begin(), init.end());
+  for (auto _ : state) {
+    state.PauseTiming();
+    GpuVector<uint64_t> v = init;
+    state.ResumeTiming();
+    Unique(v);
+    benchmark::DoNotOptimize(v.data());
+  }
+}
+BENCHMARK(ParStd_Unique)->Apply(ThreadCounts)->Unit(benchmark::kMillisecond);
+
+static void StdParUnseq_Unique(benchmark::State& state) {
+  std::vector<uint64_t> init =
+      RandomDuplicateStdVector<uint64_t>(num_bench_elements);
+  std::sort(init.begin(), init.end());
+  for (auto _ : state) {
+    state.PauseTiming();
+    std::vector<uint64_t> v = init;
+    state.ResumeTiming();
+    v.erase(std::unique(std::execution::par_unseq, v.begin(), v.end()),
+            v.end());
+    benchmark::DoNotOptimize(v.data());
+  }
+}
+BENCHMARK(StdParUnseq_Unique)->Unit(benchmark::kMillisecond);
+
+static void ParStd_Reduce(benchmark::State& state) {
+  OmpThreadsGuard threads(state.range(0));
+  const GpuVector<double> v =
+      RandomStdVector<double>(num_bench_elements, 0., 1.);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(Reduce(v, 0.));
+  }
+}
+BENCHMARK(ParStd_Reduce)->Apply(ThreadCounts)->Unit(benchmark::kMillisecond);
+
+static void StdParUnseq_Reduce(benchmark::State& state) {
+  const std::vector<double> v =
+      RandomStdVector<double>(num_bench_elements, 0., 1.);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        std::reduce(std::execution::par_unseq, v.begin(), v.end(), 0.));
+  }
+}
+BENCHMARK(StdParUnseq_Reduce)->Unit(benchmark::kMillisecond);
+
+static void ParStd_ExclusiveScan(benchmark::State& state) {
+  OmpThreadsGuard threads(state.range(0));
+  const GpuVector<uint32_t> v =
+      RandomStdVector<uint32_t>(num_bench_elements, 0, 27);
+  GpuVector<uint32_t> res(v.size());
+  for (auto _ : state) {
+    ExclusiveScan(v, res, 0u);
+    benchmark::DoNotOptimize(res.data());
+  }
+}
+BENCHMARK(ParStd_ExclusiveScan)
+    ->Apply(ThreadCounts)
+    ->Unit(benchmark::kMillisecond);
+
+static void StdParUnseq_ExclusiveScan(benchmark::State& state) {
+  const std::vector<uint32_t> v =
+      RandomStdVector<uint32_t>(num_bench_elements, 0, 27);
+  std::vector<uint32_t> res(v.size());
+  for (auto _ : state) {
+    std::exclusive_scan(std::execution::par_unseq, v.begin(), v.end(),
+                        res.begin(), 0u);
+    benchmark::DoNotOptimize(res.data());
+  }
+}
+BENCHMARK(StdParUnseq_ExclusiveScan)->Unit(benchmark::kMillisecond);
+
+static void ParStd_Merge(benchmark::State& state) {
+  OmpThreadsGuard threads(state.range(0));
+  GpuVector<uint64_t> a = RandomStdVector<uint64_t>(num_bench_elements / 2),
+                      b = RandomStdVector<uint64_t>(num_bench_elements / 2);
+  std::sort(a.begin(), a.end());
+  std::sort(b.begin(), b.end());
+  GpuVector<uint64_t> res(a.size() + b.size());
+  for (auto _ : state) {
+    Merge(a, b, res);
+    benchmark::DoNotOptimize(res.data());
+  }
+}
+BENCHMARK(ParStd_Merge)->Apply(ThreadCounts)->Unit(benchmark::kMillisecond);
+
+static void StdParUnseq_Merge(benchmark::State& state) {
+  std::vector<uint64_t> a = RandomStdVector<uint64_t>(num_bench_elements / 2),
+                        b = RandomStdVector<uint64_t>(num_bench_elements / 2);
+  std::sort(a.begin(), a.end());
+  std::sort(b.begin(), b.end());
+  std::vector<uint64_t> res(a.size() + b.size());
+  for (auto _ : state) {
+    std::merge(std::execution::par_unseq, a.begin(), a.end(), b.begin(),
+               b.end(), res.begin());
+    benchmark::DoNotOptimize(res.data());
+  }
+}
+BENCHMARK(StdParUnseq_Merge)->Unit(benchmark::kMillisecond);
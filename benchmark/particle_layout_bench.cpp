@@ -0,0 +1,168 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+
+#include "container/soa_vector.hpp"
+#include "parstd/vector.hpp"
+#include "utils/types.hpp"
+#include "wsph/derivatives.hpp"
+#include "wsph/time_stepping.hpp"
+
+// The per-particle update loops of the time stepping, streaming the positions
+// and velocities stored as arrays of Vectord (Aos) and as SoaVectors (Soa),
+// from the same source through v[i]. The compiler vectorizes the Aos loops
+// over the interleaved components with permutes, the Soa ones with one
+// particle per lane. The Particles benchmarks run the loops of the solver on
+// the Particles, whose velocities are stored in the VelocityVector layout of
+// the build, see PARTICLES_SOA. The argument is the number of particles, the
+// larger one streams from memory.
+
+using SoaVectord = SoaVector<double, 3>;
+
+constexpr double layout_dt = 1.e-4;
+constexpr double layout_ref_density = 1000.;
+constexpr double layout_pressure_parameter = 1.e5;
+
+static void LayoutSizes(benchmark::internal::Benchmark* b) {
+  b->Arg(1 << 16)->Arg(1 << 21);
+}
+
+template <typename Vectors>
+struct LayoutState {
+  explicit LayoutState(const size_t n)
+      : pos(n), vel(n), acc(n), delta(n), dty(n), prs(n), dtyD(n) {
+    for (size_t i = 0; i < n; ++i) {
+      pos[i] = Vectord(std::sin(i), std::cos(i), 0.001 * i);
+      vel[i] = Vectord(0.1 * std::cos(i), 0., -0.1);
+      acc[i] = Vectord(0., std::sin(3 * i), -9.);
+      delta[i] = Vectord(1.e-6 * std::sin(7 * i));
+      dty[i] = layout_ref_density + std::sin(5 * i);
+      dtyD[i] = std::cos(5 * i);
+    }
+  }
+  Vectors pos, vel, acc, delta;
+  GpuVector<double> dty, prs, dtyD;
+};
+
+// Derivative::Step
+template <typename Vectors>
+static void LayoutStep(LayoutState<Vectors>& s, const Vectord gravity) {
+#pragma omp parallel for schedule(static)
+  for (size_t i = 0; i < s.pos.size(); ++i) {
+    s.dty[i] += layout_dt * s.dtyD[i];
+    s.prs[i] = ComputePressure(s.dty[i], layout_ref_density,
+                               layout_pressure_parameter);
+    s.vel[i] += layout_dt * (s.acc[i] + gravity);
+    s.pos[i] = s.pos[i] + layout_dt * s.vel[i];
+  }
+}
+
+// DpcShifting::Apply, acc is the collision and delta the repulsive term
+template <typename Vectors>
+static void LayoutShift(LayoutState<Vectors>& s) {
+#pragma omp parallel for schedule(static)
+  for (size_t i = 0; i < s.pos.size(); ++i) {
+    const Vectord delta = s.acc[i] + layout_dt * s.delta[i];
+    s.vel[i] += delta;
+    s.pos[i] = s.pos[i] + layout_dt * delta;
+  }
+}
+
+// the bytes read and written per particle
+static void SetLayoutCounters(benchmark::State& state, const int vectors,
+                              const int scalars) {
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+  state.SetBytesProcessed(state.iterations() * state.range(0) *
+                          (vectors * sizeof(Vectord) +
+                           scalars * sizeof(double)));
+}
+
+template <typename Vectors>
+static void Layout_Step(benchmark::State& state) {
+  LayoutState<Vectors> s(state.range(0));
+  for (auto _ : state) {
+    LayoutStep(s, Vectord(0., 0., -9.81));
+    benchmark::DoNotOptimize(&s.pos);
+  }
+  SetLayoutCounters(state, 5, 4);
+}
+BENCHMARK(Layout_Step<GpuVector<Vectord>>)->Apply(LayoutSizes);
+BENCHMARK(Layout_Step<SoaVectord>)->Apply(LayoutSizes);
+
+template <typename Vectors>
+static void Layout_Shift(benchmark::State& state) {
+  LayoutState<Vectors> s(state.range(0));
+  for (auto _ : state) {
+    LayoutShift(s);
+    benchmark::DoNotOptimize(&s.pos);
+  }
+  SetLayoutCounters(state, 6, 0);
+}
+BENCHMARK(Layout_Shift<GpuVector<Vectord>>)->Apply(LayoutSizes);
+BENCHMARK(Layout_Shift<SoaVectord>)->Apply(LayoutSizes);
+
+// a block of water particles without boundary
+static Domain LayoutDomain(const size_t n) {
+  const MaterialSettings s = MaterialSettings::Water();
+  std::vector<Vectord> pos(n), vel(n);
+  for (size_t i = 0; i < n; ++i) {
+    pos[i] = s.dr * Vectord(i % 64, (i / 64) % 64, i / 4096);
+    vel[i] = Vectord(0.1 * std::cos(i), 0., -0.1);
+  }
+  return Domain(Particles(s, std::move(pos), std::move(vel)));
+}
+
+// the layout of the particle velocities of the build
+static void SetParticlesLabel(benchmark::State& state) {
+  state.SetLabel(std::is_same_v<VelocityVector, GpuVector<Vectord>>
+                     ? "velocities aos"
+                     : "velocities soa");
+}
+
+static void Particles_DerivativeStep(benchmark::State& state) {
+  Domain d = LayoutDomain(state.range(0));
+  Derivative res;
+  res.Resize(d.p.size());
+  std::fill(res.acc.begin(), res.acc.end(), Vectord(0., 0.1, 0.));
+  std::fill(res.dtyD.begin(), res.dtyD.end(), 1.);
+  for (auto _ : state) {
+    res.Step(layout_dt, Vectord(0., 0., -9.81), d);
+    benchmark::DoNotOptimize(&d.p);
+  }
+  SetLayoutCounters(state, 5, 4);
+  SetParticlesLabel(state);
+}
+BENCHMARK(Particles_DerivativeStep)->Apply(LayoutSizes);
+
+// DualSPHysicsVerletTS::IntegrateFinalStep, from the state of a predictor
+// step with the derivative of a short time step
+static void Particles_IntegrateFinalStep(benchmark::State& state) {
+  Domain d = LayoutDomain(state.range(0));
+  DualSPHysicsVerletTS ts(Vectord(0., 0., -9.81));
+  ts.TimeStep(1.e-8, d);
+  ts.IntegratePredictorStep(layout_dt / 2., d);
+  for (auto _ : state) {
+    ts.IntegrateFinalStep(layout_dt, d);
+    benchmark::DoNotOptimize(&d.p);
+  }
+  // the current and initial positions and velocities, the acceleration, the
+  // current density written and the initial one and dtyD read
+  SetLayoutCounters(state, 6, 4);
+  SetParticlesLabel(state);
+}
+BENCHMARK(Particles_IntegrateFinalStep)->Apply(LayoutSizes);
+
+static void Particles_DpcShiftingApply(benchmark::State& state) {
+  Domain d = LayoutDomain(state.range(0));
+  DpcShifting shifting;
+  shifting.Compute(d);
+  for (auto _ : state) {
+    shifting.Apply(layout_dt, d);
+    benchmark::DoNotOptimize(&d.p);
+  }
+  SetLayoutCounters(state, 6, 0);
+  SetParticlesLabel(state);
+}
+BENCHMARK(Particles_DpcShiftingApply)->Apply(LayoutSizes);
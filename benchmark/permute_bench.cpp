@@ -0,0 +1,133 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <random>
+#include <tuple>
+
+#include "helper_cpu_bench.hpp"
+#include "neighbor/field_gather.hpp"
+#include "neighbor/point_cell_list.hpp"
+#include "parstd/parstd.hpp"
+
+// Reordering of the particle fields (position, velocity, density, pressure)
+// with the out-of-place FieldGather against PermuteInPlace. The first argument
+// selects the index map: 0 is the map of a cell list update after every point
+// moved by up to a third of the cell size, mostly short cycles within the
+// cells, 1 a random permutation, i.e. a few long cycles. extra_mb is the
+// memory the reordering needs on top of the fields.
+
+constexpr size_t num_permute_points = 4'000'000;
+
+static void IndexMaps(benchmark::internal::Benchmark* b) {
+  b->Arg(0)->Arg(1);
+}
+
+static double PermuteCellSize() {
+  return 2. * std::cbrt(1. / num_permute_points);
+}
+
+// random points in the unit cube, sorted into a cell list
+static PointCellListD CreateCellList() {
+  const GpuVector<Vectord> points =
+      RandomStdVectorVectorNT<3, double>(num_permute_points, 0., 1.);
+  auto res = std::get<1>(PointCellListD::Create(PermuteCellSize(), points));
+  GetStepArena().Reset();
+  return res;
+}
+
+static std::vector<Vectord> Jitter(const double max_offset) {
+  return RandomStdVectorVectorNT<3, double>(num_permute_points, -max_offset,
+                                            max_offset);
+}
+
+static GpuVector<SizeT> BenchIndexMap(const int kind) {
+  if (kind == 1) {
+    GpuVector<SizeT> res(num_permute_points);
+    std::iota(res.begin(), res.end(), 0);
+    std::shuffle(res.begin(), res.end(), std::mt19937(3));
+    return res;
+  }
+  PointCellListD cell_list = CreateCellList();
+  const auto jitter = Jitter(PermuteCellSize() / 3.);
+  for (SizeT i = 0; i < cell_list.size(); ++i) {
+    cell_list[i] = cell_list[i] + jitter[i];
+  }
+  const auto index_map = cell_list.Update();
+  GpuVector<SizeT> res(index_map.begin(), index_map.end());
+  GetStepArena().Reset();
+  return res;
+}
+
+struct PermuteFields {
+  GpuVector<Vectord> pos, vel;
+  GpuVector<double> dty, prs;
+
+  PermuteFields()
+      : pos(RandomStdVectorVectorNT<3, double>(num_permute_points, 0., 1.)),
+        vel(pos),
+        dty(RandomStdVector<double>(num_permute_points, 1000., 1001.)),
+        prs(dty) {}
+
+  auto tie() { return std::tie(pos, vel, dty, prs); }
+
+  static double Bytes() {
+    return num_permute_points * (2. * sizeof(Vectord) + 2. * sizeof(double));
+  }
+};
+
+static void Permute_Gather(benchmark::State& state) {
+  const GpuVector<SizeT> index_map = BenchIndexMap(state.range(0));
+  PermuteFields fields;
+  FieldGather gather;
+  for (auto _ : state) {
+    gather(index_map, fields.tie());
+    benchmark::DoNotOptimize(fields.pos.data());
+  }
+  state.counters["extra_mb"] = PermuteFields::Bytes() / 1e6;
+  state.SetBytesProcessed(state.iterations() * PermuteFields::Bytes());
+}
+BENCHMARK(Permute_Gather)->Apply(IndexMaps)->Unit(benchmark::kMillisecond);
+
+static void Permute_InPlace(benchmark::State& state) {
+  const GpuVector<SizeT> index_map = BenchIndexMap(state.range(0));
+  PermuteFields fields;
+  for (auto _ : state) {
+    std::apply([&](auto&... f) { PermuteInPlace(index_map, f...); },
+               fields.tie());
+    benchmark::DoNotOptimize(fields.pos.data());
+  }
+  state.counters["extra_mb"] = num_permute_points / 8. / 1e6;
+  state.SetBytesProcessed(state.iterations() * PermuteFields::Bytes());
+}
+BENCHMARK(Permute_InPlace)->Apply(IndexMaps)->Unit(benchmark::kMillisecond);
+
+// The cell list update itself, the argument is the PermutePolicy. The points
+// are moved back and forth between the iterations, so every update permutes.
+static void Permute_PointCellListUpdate(benchmark::State& state) {
+  const PermutePolicy prev = GetPermutePolicy();
+  SetPermutePolicy(static_cast<PermutePolicy>(state.range(0)));
+  PointCellListD cell_list = CreateCellList();
+  const auto jitter = Jitter(PermuteCellSize() / 3.);
+  size_t scratch_bytes = 0;
+  double sign = 1.;
+  for (auto _ : state) {
+    state.PauseTiming();
+    for (SizeT i = 0; i < cell_list.size(); ++i) {
+      cell_list[i] = cell_list[i] + sign * jitter[i];
+    }
+    sign = -sign;
+    state.ResumeTiming();
+    const auto index_map = cell_list.Update();
+    benchmark::DoNotOptimize(index_map.data());
+    scratch_bytes = std::max(scratch_bytes, GetStepArena().BytesInUse());
+    GetStepArena().Reset();
+  }
+  state.counters["scratch_mb"] = scratch_bytes / 1e6;
+  SetPermutePolicy(prev);
+}
+BENCHMARK(Permute_PointCellListUpdate)
+    ->Arg(static_cast<int>(PermutePolicy::kGather))
+    ->Arg(static_cast<int>(PermutePolicy::kInPlace))
+    ->Unit(benchmark::kMillisecond);
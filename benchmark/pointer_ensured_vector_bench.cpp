@@ -0,0 +1,123 @@
+#include <benchmark/benchmark.h>
+#include <omp.h>
+
+#include <array>
+#include <mutex>
+#include <vector>
+
+#include "container/pointer_ensured_vector.hpp"
+#include "helper_cpu_bench.hpp"
+
+// Creation and release of small records by all threads at once, e.g. probe
+// records or inflow particles. Every thread creates a batch of records, frees
+// them and repeats, the first argument is the number of OpenMP threads.
+
+constexpr size_t num_pool_batches = 64;
+constexpr size_t pool_batch_size = 4096;
+
+struct PoolRecord {
+  std::array<double, 6> values;
+  int64_t id;
+
+  explicit PoolRecord(const int64_t i = 0) : id(i) {}
+};
+
+static void SetPoolCounters(benchmark::State& state) {
+  state.SetItemsProcessed(state.iterations() * state.range(0) *
+                          num_pool_batches * pool_batch_size);
+}
+
+static void Pool_PointerEnsuredVector(benchmark::State& state) {
+  OmpThreadsGuard threads(state.range(0));
+  PointerEnsuredVector<PoolRecord> pool;
+  for (auto _ : state) {
+#pragma omp parallel
+    {
+      std::vector<PoolRecord*> batch(pool_batch_size);
+      for (size_t b = 0; b < num_pool_batches; ++b) {
+        for (size_t i = 0; i < pool_batch_size; ++i) {
+          batch[i] = pool.GetNewData(i);
+        }
+        benchmark::DoNotOptimize(batch.data());
+        for (PoolRecord* r : batch) {
+          pool.Free(r);
+        }
+      }
+    }
+  }
+  SetPoolCounters(state);
+}
+BENCHMARK(Pool_PointerEnsuredVector)
+    ->Apply(ThreadCounts)
+    ->Unit(benchmark::kMillisecond);
+
+static void Pool_PointerEnsuredVectorBulk(benchmark::State& state) {
+  OmpThreadsGuard threads(state.range(0));
+  PointerEnsuredVector<PoolRecord> pool;
+  for (auto _ : state) {
+#pragma omp parallel
+    {
+      for (size_t b = 0; b < num_pool_batches; ++b) {
+        const std::vector<PoolRecord*> batch =
+            pool.GetNewDataBulk(pool_batch_size);
+        benchmark::DoNotOptimize(batch.data());
+        for (PoolRecord* r : batch) {
+          pool.Free(r);
+        }
+      }
+    }
+  }
+  SetPoolCounters(state);
+}
+BENCHMARK(Pool_PointerEnsuredVectorBulk)
+    ->Apply(ThreadCounts)
+    ->Unit(benchmark::kMillisecond);
+
+static void Pool_NewDelete(benchmark::State& state) {
+  OmpThreadsGuard threads(state.range(0));
+  for (auto _ : state) {
+#pragma omp parallel
+    {
+      std::vector<PoolRecord*> batch(pool_batch_size);
+      for (size_t b = 0; b < num_pool_batches; ++b) {
+        for (size_t i = 0; i < pool_batch_size; ++i) {
+          batch[i] = new PoolRecord(i);
+        }
+        benchmark::DoNotOptimize(batch.data());
+        for (PoolRecord* r : batch) {
+          delete r;
+        }
+      }
+    }
+  }
+  SetPoolCounters(state);
+}
+BENCHMARK(Pool_NewDelete)->Apply(ThreadCounts)->Unit(benchmark::kMillisecond);
+
+// a shared vector behind a mutex, cleared after every batch
+static void Pool_StdVectorPushBack(benchmark::State& state) {
+  OmpThreadsGuard threads(state.range(0));
+  std::vector<PoolRecord> records;
+  std::mutex mutex;
+  for (auto _ : state) {
+#pragma omp parallel
+    {
+      for (size_t b = 0; b < num_pool_batches; ++b) {
+        for (size_t i = 0; i < pool_batch_size; ++i) {
+          std::lock_guard<std::mutex> lock(mutex);
+          records.emplace_back(i);
+        }
+#pragma omp barrier
+#pragma omp single
+        {
+          benchmark::DoNotOptimize(records.data());
+          records.clear();
+        }
+      }
+    }
+  }
+  SetPoolCounters(state);
+}
+BENCHMARK(Pool_StdVectorPushBack)
+    ->Apply(ThreadCounts)
+    ->Unit(benchmark::kMillisecond);
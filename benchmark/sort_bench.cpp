@@ -0,0 +1,171 @@
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstdint>
+
+#include "algo/morton.hpp"
+#include "helper_cpu_bench.hpp"
+#include "parstd/par_sort_own.hpp"
+#include "parstd/parstd.hpp"
+
+// Sorting of 64 bit keys and morton-index pairs and merging of two sorted
+// halves, from 1M to 64M elements.
+// The keys are limited to 48 bits, roughly the morton codes of a 65k^3 grid.
+
+constexpr uint64_t max_sort_key = (uint64_t(1) << 48) - 1;
+
+static void SortSizes(benchmark::internal::Benchmark* b) {
+  b->RangeMultiplier(4)->Range(1 << 20, 1 << 26);
+}
+
+static GpuVector<MortIdx<Morton64>> RandomMortIdx(const size_t n) {
+  const auto keys = RandomStdVector<uint64_t>(n, 0, max_sort_key);
+  GpuVector<MortIdx<Morton64>> res(n);
+  for (size_t i = 0; i < n; ++i) {
+    res[i] = {Morton64(keys[i]), static_cast<uint32_t>(i)};
+  }
+  return res;
+}
+
+static void Sort_RadixSort(benchmark::State& state) {
+  const GpuVector<uint64_t> init =
+      RandomStdVector<uint64_t>(state.range(0), 0, max_sort_key);
+  for (auto _ : state) {
+    state.PauseTiming();
+    GpuVector<uint64_t> v = init;
+    state.ResumeTiming();
+    RadixSort(v);
+    benchmark::DoNotOptimize(v.data());
+  }
+}
+BENCHMARK(Sort_RadixSort)->Apply(SortSizes)->Unit(benchmark::kMillisecond);
+
+static void Sort_StdSort(benchmark::State& state) {
+  const std::vector<uint64_t> init =
+      RandomStdVector<uint64_t>(state.range(0), 0, max_sort_key);
+  for (auto _ : state) {
+    state.PauseTiming();
+    std::vector<uint64_t> v = init;
+    state.ResumeTiming();
+    std::sort(v.begin(), v.end());
+    benchmark::DoNotOptimize(v.data());
+  }
+}
+BENCHMARK(Sort_StdSort)->Apply(SortSizes)->Unit(benchmark::kMillisecond);
+
+static void Sort_SortParallelMerge(benchmark::State& state) {
+  const std::vector<uint64_t> init =
+      RandomStdVector<uint64_t>(state.range(0), 0, max_sort_key);
+  for (auto _ : state) {
+    state.PauseTiming();
+    std::vector<uint64_t> v = init;
+    state.ResumeTiming();
+    SortParallelMerge(v);
+    benchmark::DoNotOptimize(v.data());
+  }
+}
+BENCHMARK(Sort_SortParallelMerge)
+    ->Apply(SortSizes)
+    ->Unit(benchmark::kMillisecond);
+
+static void Sort_SortParallelSample(benchmark::State& state) {
+  const std::vector<uint64_t> init =
+      RandomStdVector<uint64_t>(state.range(0), 0, max_sort_key);
+  GpuVector<uint64_t> scratch;
+  for (auto _ : state) {
+    state.PauseTiming();
+    std::vector<uint64_t> v = init;
+    state.ResumeTiming();
+    SortParallelSample(v, scratch);
+    benchmark::DoNotOptimize(v.data());
+  }
+}
+BENCHMARK(Sort_SortParallelSample)
+    ->Apply(SortSizes)
+    ->Unit(benchmark::kMillisecond);
+
+// chunk sort followed by merge path merges, the comparison based parstd Sort
+static void Sort_MergePathSort(benchmark::State& state) {
+  const std::vector<uint64_t> init =
+      RandomStdVector<uint64_t>(state.range(0), 0, max_sort_key);
+  for (auto _ : state) {
+    state.PauseTiming();
+    std::vector<uint64_t> v = init;
+    state.ResumeTiming();
+    internal::omp::sort(std_exec_policy(), v.begin(), v.end());
+    benchmark::DoNotOptimize(v.data());
+  }
+}
+BENCHMARK(Sort_MergePathSort)->Apply(SortSizes)->Unit(benchmark::kMillisecond);
+
+static void Sort_RadixSortMortIdx(benchmark::State& state) {
+  const GpuVector<MortIdx<Morton64>> init = RandomMortIdx(state.range(0));
+  for (auto _ : state) {
+    state.PauseTiming();
+    GpuVector<MortIdx<Morton64>> v = init;
+    state.ResumeTiming();
+    RadixSort(v);
+    benchmark::DoNotOptimize(v.data());
+  }
+}
+BENCHMARK(Sort_RadixSortMortIdx)
+    ->Apply(SortSizes)
+    ->Unit(benchmark::kMillisecond);
+
+static void Sort_StdSortMortIdx(benchmark::State& state) {
+  const GpuVector<MortIdx<Morton64>> init = RandomMortIdx(state.range(0));
+  for (auto _ : state) {
+    state.PauseTiming();
+    GpuVector<MortIdx<Morton64>> v = init;
+    state.ResumeTiming();
+    std::sort(v.begin(), v.end());
+    benchmark::DoNotOptimize(v.data());
+  }
+}
+BENCHMARK(Sort_StdSortMortIdx)
+    ->Apply(SortSizes)
+    ->Unit(benchmark::kMillisecond);
+
+static void Sort_SortParallelSampleMortIdx(benchmark::State& state) {
+  const GpuVector<MortIdx<Morton64>> init = RandomMortIdx(state.range(0));
+  for (auto _ : state) {
+    state.PauseTiming();
+    GpuVector<MortIdx<Morton64>> v = init;
+    state.ResumeTiming();
+    SortParallelSample(v);
+    benchmark::DoNotOptimize(v.data());
+  }
+}
+BENCHMARK(Sort_SortParallelSampleMortIdx)
+    ->Apply(SortSizes)
+    ->Unit(benchmark::kMillisecond);
+
+static void Merge_MergeParallel(benchmark::State& state) {
+  std::vector<uint64_t> a = RandomStdVector<uint64_t>(state.range(0) / 2, 0,
+                                                      max_sort_key),
+                        b = RandomStdVector<uint64_t>(state.range(0) / 2, 0,
+                                                      max_sort_key);
+  std::sort(a.begin(), a.end());
+  std::sort(b.begin(), b.end());
+  std::vector<uint64_t> res(a.size() + b.size());
+  for (auto _ : state) {
+    MergeParallel(a, b, res);
+    benchmark::DoNotOptimize(res.data());
+  }
+}
+BENCHMARK(Merge_MergeParallel)->Apply(SortSizes)->Unit(benchmark::kMillisecond);
+
+static void Merge_StdMerge(benchmark::State& state) {
+  std::vector<uint64_t> a = RandomStdVector<uint64_t>(state.range(0) / 2, 0,
+                                                      max_sort_key),
+                        b = RandomStdVector<uint64_t>(state.range(0) / 2, 0,
+                                                      max_sort_key);
+  std::sort(a.begin(), a.end());
+  std::sort(b.begin(), b.end());
+  std::vector<uint64_t> res(a.size() + b.size());
+  for (auto _ : state) {
+    std::merge(a.begin(), a.end(), b.begin(), b.end(), res.begin());
+    benchmark::DoNotOptimize(res.data());
+  }
+}
+BENCHMARK(Merge_StdMerge)->Apply(SortSizes)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,429 @@
+#include <benchmark/benchmark.h>
+
+#include <cmath>
+#include <vector>
+
+#include "helper_cpu_bench.hpp"
+#include "parstd/prefetch.hpp"
+#include "parstd/simd.hpp"
+#include "wsph/derivatives.hpp"
+#include "wsph/pair_loop.hpp"
+#include "wsph/pair_stage.hpp"
+#include "wsph/particle_boundary.hpp"
+
+// The particle loops of the WSPH operators on a jittered block of 40^3 water
+// particles above a boundary plate, on all OpenMP threads. The first argument
+// is the SimdIsa of the loops (0 scalar, 1 avx2, 2 avx512), the second one is 1
+// for the tabulated kernel. interactions is the number of particle pairs
+// processed per second. RhsFillCache also writes the PairCache. The Prefetch
+// benchmarks sweep the prefetch distance of the scalar loops, the Tiles
+// benchmarks the size of the cell tiles. The Records benchmarks gather the
+// neighbors from the packed PairRecords, the Layout benchmarks compare the
+// layouts of the neighbor fields on a reduced pair loop.
+
+constexpr int pairs_block_size = 40;
+
+static Domain MakePairsDomain(const bool tabulated) {
+  MaterialSettings s = MaterialSettings::Water();
+  s.tabulated_kernel = tabulated;
+  std::vector<Vectord> pos, vel, b_pos, b_normal;
+  for (int x = 0; x < pairs_block_size; ++x) {
+    for (int y = 0; y < pairs_block_size; ++y) {
+      for (int z = 0; z < pairs_block_size; ++z) {
+        const int k = pos.size();
+        pos.push_back(s.dr * (Vectord(x, y, z + 1) +
+                              0.05 * Vectord(std::sin(k), std::cos(3 * k),
+                                             std::sin(7 * k))));
+        vel.push_back(Vectord(0.01 * std::sin(k), 0., -0.01 * z));
+      }
+    }
+  }
+  for (int x = -2; x < pairs_block_size + 2; ++x) {
+    for (int y = -2; y < pairs_block_size + 2; ++y) {
+      b_pos.push_back(s.dr * Vectord(x, y, 0));
+      b_normal.push_back(Vectord(0., 0., 1.));
+    }
+  }
+  std::vector<Vectord> b_vel(b_pos.size(), Vectord(0.));
+  return Domain(Particles(s, std::move(pos), std::move(vel)),
+                ParticleBoundary(s, std::move(b_pos), std::move(b_normal),
+                                 std::move(b_vel)));
+}
+
+static Domain& PairsDomain(const bool tabulated) {
+  if (tabulated) {
+    static Domain d = MakePairsDomain(true);
+    return d;
+  }
+  static Domain d = MakePairsDomain(false);
+  return d;
+}
+
+static double NumPairs(const SavedNeighborsD& sn, const SizeT n) {
+  double res = 0.;
+  for (SizeT i = 0; i < n; ++i) {
+    res += sn.neighbors(i).size();
+  }
+  return res;
+}
+
+static void SimdIsas(benchmark::internal::Benchmark* b) {
+  b->ArgsProduct({{0, 1, 2}, {0, 1}});
+}
+
+// false if the cpu does not support the SimdIsa of the first argument
+static bool SetBenchSimdIsa(benchmark::State& state) {
+  const SimdIsa isa = static_cast<SimdIsa>(state.range(0));
+  if (isa > DetectSimdIsa()) {
+    state.SkipWithError("instruction set not supported");
+    return false;
+  }
+  SetSimdIsa(isa);
+  return true;
+}
+
+static void Pairs_Rhs(benchmark::State& state) {
+  if (!SetBenchSimdIsa(state)) return;
+  const Domain& d = PairsDomain(state.range(1));
+  BasicWeaklyRhs rhs;
+  Derivative res;
+  for (auto _ : state) {
+    rhs.Compute(d, res);
+    benchmark::DoNotOptimize(res.acc.data());
+  }
+  state.counters["interactions"] = benchmark::Counter(
+      NumPairs(d.p_p_neighbors, d.p.size()) +
+          NumPairs(d.p_pb_neighbors, d.p.size()),
+      benchmark::Counter::kIsIterationInvariantRate);
+  SetSimdIsa(DetectSimdIsa());
+}
+BENCHMARK(Pairs_Rhs)->Apply(SimdIsas)->Unit(benchmark::kMillisecond);
+
+// the RHS filling the PairCache of both neighbor lists
+static void Pairs_RhsFillCache(benchmark::State& state) {
+  if (!SetBenchSimdIsa(state)) return;
+  Domain& d = PairsDomain(state.range(1));
+  SetPairCachePolicy(PairCachePolicy::kOn);
+  d.PlanPairCache(1);
+  BasicWeaklyRhs rhs;
+  Derivative res;
+  for (auto _ : state) {
+    rhs.Compute(d, res);
+    benchmark::DoNotOptimize(res.acc.data());
+  }
+  state.counters["interactions"] = benchmark::Counter(
+      NumPairs(d.p_p_neighbors, d.p.size()) +
+          NumPairs(d.p_pb_neighbors, d.p.size()),
+      benchmark::Counter::kIsIterationInvariantRate);
+  SetPairCachePolicy(PairCachePolicy::kOff);
+  d.PlanPairCache(1);
+  SetSimdIsa(DetectSimdIsa());
+}
+BENCHMARK(Pairs_RhsFillCache)->Apply(SimdIsas)->Unit(benchmark::kMillisecond);
+
+static void Pairs_DpcShifting(benchmark::State& state) {
+  if (!SetBenchSimdIsa(state)) return;
+  const Domain& d = PairsDomain(state.range(1));
+  DpcShifting shifting;
+  for (auto _ : state) {
+    shifting.Compute(d);
+    benchmark::DoNotOptimize(shifting.collision_term().data());
+  }
+  state.counters["interactions"] = benchmark::Counter(
+      NumPairs(d.p_p_neighbors, d.p.size()) +
+          NumPairs(d.p_pb_neighbors, d.p.size()),
+      benchmark::Counter::kIsIterationInvariantRate);
+  SetSimdIsa(DetectSimdIsa());
+}
+BENCHMARK(Pairs_DpcShifting)->Apply(SimdIsas)->Unit(benchmark::kMillisecond);
+
+// A kernel evaluation W and gradient of every pair of the 40^3 block over
+// dist2, analytic (0) or tabulated (1), without any particle data.
+static void Kernel_WendlandGradient(benchmark::State& state) {
+  const Domain& d = PairsDomain(false);
+  std::vector<double> dist2;
+  for (SizeT i = 0; i < d.p.size(); ++i) {
+    for (const SizeT j : d.p_p_neighbors.neighbors(i)) {
+      const Vectord rij = d.p.pos(i) - d.p.pos(j);
+      dist2.push_back(rij * rij);
+    }
+  }
+  DispatchKernel(KernelType::kWendland, state.range(0), d.p.h(),
+                 [&](const auto& kernel) {
+                   for (auto _ : state) {
+                     double sum = 0.;
+                     for (const double r2 : dist2) {
+                       sum += kernel.WOfDist2(r2) + kernel.GradientOverDist(r2);
+                     }
+                     benchmark::DoNotOptimize(sum);
+                   }
+                 });
+  state.counters["interactions"] = benchmark::Counter(
+      dist2.size(), benchmark::Counter::kIsIterationInvariantRate);
+}
+BENCHMARK(Kernel_WendlandGradient)
+    ->Arg(0)
+    ->Arg(1)
+    ->Unit(benchmark::kMillisecond);
+
+// The scalar loops with the fields of the neighbors prefetched the argument
+// number of neighbors ahead, 0 disables the prefetching.
+static void PrefetchDistances(benchmark::internal::Benchmark* b) {
+  b->Arg(0)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->Arg(16);
+}
+
+static void Prefetch_Rhs(benchmark::State& state) {
+  SetSimdIsa(SimdIsa::kScalar);
+  SetPrefetchDistance(state.range(0));
+  const Domain& d = PairsDomain(false);
+  BasicWeaklyRhs rhs;
+  Derivative res;
+  for (auto _ : state) {
+    rhs.Compute(d, res);
+    benchmark::DoNotOptimize(res.acc.data());
+  }
+  state.counters["interactions"] = benchmark::Counter(
+      NumPairs(d.p_p_neighbors, d.p.size()) +
+          NumPairs(d.p_pb_neighbors, d.p.size()),
+      benchmark::Counter::kIsIterationInvariantRate);
+  SetPrefetchDistance(0);
+  SetSimdIsa(DetectSimdIsa());
+}
+BENCHMARK(Prefetch_Rhs)
+    ->Apply(PrefetchDistances)
+    ->Unit(benchmark::kMillisecond);
+
+static void Prefetch_DpcShifting(benchmark::State& state) {
+  SetSimdIsa(SimdIsa::kScalar);
+  SetPrefetchDistance(state.range(0));
+  const Domain& d = PairsDomain(false);
+  DpcShifting shifting;
+  for (auto _ : state) {
+    shifting.Compute(d);
+    benchmark::DoNotOptimize(shifting.collision_term().data());
+  }
+  state.counters["interactions"] = benchmark::Counter(
+      NumPairs(d.p_p_neighbors, d.p.size()) +
+          NumPairs(d.p_pb_neighbors, d.p.size()),
+      benchmark::Counter::kIsIterationInvariantRate);
+  SetPrefetchDistance(0);
+  SetSimdIsa(DetectSimdIsa());
+}
+BENCHMARK(Prefetch_DpcShifting)
+    ->Apply(PrefetchDistances)
+    ->Unit(benchmark::kMillisecond);
+
+// The scalar loops over cell tiles whose staged neighbor fields take the
+// argument in KB, 0 reads the neighbors in place. -1 is the L2 cache of a core.
+static void TileKBytes(benchmark::internal::Benchmark* b) {
+  b->Arg(0)->Arg(64)->Arg(256)->Arg(1024)->Arg(-1);
+}
+
+static void SetBenchTileBytes(benchmark::State& state) {
+  SetSimdIsa(SimdIsa::kScalar);
+  SetPairTileBytes(state.range(0) < 0 ? DetectL2CacheBytes()
+                                      : state.range(0) * 1024);
+}
+
+static void Tiles_Rhs(benchmark::State& state) {
+  SetBenchTileBytes(state);
+  const Domain& d = PairsDomain(false);
+  BasicWeaklyRhs rhs;
+  Derivative res;
+  for (auto _ : state) {
+    rhs.Compute(d, res);
+    benchmark::DoNotOptimize(res.acc.data());
+  }
+  state.counters["interactions"] = benchmark::Counter(
+      NumPairs(d.p_p_neighbors, d.p.size()) +
+          NumPairs(d.p_pb_neighbors, d.p.size()),
+      benchmark::Counter::kIsIterationInvariantRate);
+  SetPairTileBytes(0);
+  SetSimdIsa(DetectSimdIsa());
+}
+BENCHMARK(Tiles_Rhs)->Apply(TileKBytes)->Unit(benchmark::kMillisecond);
+
+static void Tiles_DpcShifting(benchmark::State& state) {
+  SetBenchTileBytes(state);
+  const Domain& d = PairsDomain(false);
+  DpcShifting shifting;
+  for (auto _ : state) {
+    shifting.Compute(d);
+    benchmark::DoNotOptimize(shifting.collision_term().data());
+  }
+  state.counters["interactions"] = benchmark::Counter(
+      NumPairs(d.p_p_neighbors, d.p.size()) +
+          NumPairs(d.p_pb_neighbors, d.p.size()),
+      benchmark::Counter::kIsIterationInvariantRate);
+  SetPairTileBytes(0);
+  SetSimdIsa(DetectSimdIsa());
+}
+BENCHMARK(Tiles_DpcShifting)->Apply(TileKBytes)->Unit(benchmark::kMillisecond);
+
+// The loops gathering the hot fields of the neighbors from the PairRecords
+// (second argument 1) or from the separate arrays.
+static void PairRecordsArgs(benchmark::internal::Benchmark* b) {
+  b->ArgsProduct({{0, 1, 2}, {0, 1}});
+}
+
+static void Records_Rhs(benchmark::State& state) {
+  if (!SetBenchSimdIsa(state)) return;
+  SetPairRecords(state.range(1));
+  const Domain& d = PairsDomain(false);
+  BasicWeaklyRhs rhs;
+  Derivative res;
+  for (auto _ : state) {
+    rhs.Compute(d, res);
+    benchmark::DoNotOptimize(res.acc.data());
+  }
+  state.counters["interactions"] = benchmark::Counter(
+      NumPairs(d.p_p_neighbors, d.p.size()) +
+          NumPairs(d.p_pb_neighbors, d.p.size()),
+      benchmark::Counter::kIsIterationInvariantRate);
+  SetPairRecords(false);
+  SetSimdIsa(DetectSimdIsa());
+}
+BENCHMARK(Records_Rhs)->Apply(PairRecordsArgs)->Unit(benchmark::kMillisecond);
+
+static void Records_DpcShifting(benchmark::State& state) {
+  if (!SetBenchSimdIsa(state)) return;
+  SetPairRecords(state.range(1));
+  const Domain& d = PairsDomain(false);
+  d.UpdateDerivedFields();
+  DpcShifting shifting;
+  for (auto _ : state) {
+    shifting.Compute(d);
+    benchmark::DoNotOptimize(shifting.collision_term().data());
+  }
+  state.counters["interactions"] = benchmark::Counter(
+      NumPairs(d.p_p_neighbors, d.p.size()) +
+          NumPairs(d.p_pb_neighbors, d.p.size()),
+      benchmark::Counter::kIsIterationInvariantRate);
+  SetPairRecords(false);
+  d.UpdateDerivedFields();
+  SetSimdIsa(DetectSimdIsa());
+}
+BENCHMARK(Records_DpcShifting)
+    ->Apply(PairRecordsArgs)
+    ->Unit(benchmark::kMillisecond);
+
+// The hot fields of the fluid particles in the layouts of the Layout
+// benchmarks: the separate arrays of the Particles, one array per component
+// (SoA), the 64 byte PairRecords and 32 byte records of floats.
+namespace {
+struct HotFields {
+  double x, y, z, vx, vy, vz, dty, prs;
+};
+
+struct SeparateLayout {
+  explicit SeparateLayout(const Particles& p) : fields(p) {}
+  HotFields operator[](const SizeT j) const {
+    const Vectord& pos = fields.pos(j);
+    const Vectord& vel = fields.vel(j);
+    return {pos[0], pos[1], pos[2],          vel[0],
+            vel[1], vel[2], fields.dty(j), fields.prs(j)};
+  }
+  PairFields fields;
+};
+
+struct SoaLayout {
+  explicit SoaLayout(const Particles& p) {
+    for (auto* v : {&x, &y, &z, &vx, &vy, &vz, &dty, &prs}) {
+      v->resize(p.size());
+    }
+    for (SizeT i = 0; i < p.size(); ++i) {
+      x[i] = p.pos(i)[0];
+      y[i] = p.pos(i)[1];
+      z[i] = p.pos(i)[2];
+      vx[i] = p.vel(i)[0];
+      vy[i] = p.vel(i)[1];
+      vz[i] = p.vel(i)[2];
+      dty[i] = p.dty(i);
+      prs[i] = p.prs(i);
+    }
+  }
+  HotFields operator[](const SizeT j) const {
+    return {x[j], y[j], z[j], vx[j], vy[j], vz[j], dty[j], prs[j]};
+  }
+  std::vector<double> x, y, z, vx, vy, vz, dty, prs;
+};
+
+struct RecordLayout {
+  explicit RecordLayout(const Particles& p) : records(p.size()) {
+    for (SizeT i = 0; i < p.size(); ++i) {
+      records[i] = {p.pos(i), p.vel(i), p.dty(i), p.prs(i)};
+    }
+  }
+  HotFields operator[](const SizeT j) const {
+    const PairRecord& r = records[j];
+    return {r.pos[0], r.pos[1], r.pos[2], r.vel[0],
+            r.vel[1], r.vel[2], r.dty,    r.prs};
+  }
+  std::vector<PairRecord> records;
+};
+
+struct alignas(32) FloatRecord {
+  float pos[3], vel[3], dty, prs;
+};
+static_assert(sizeof(FloatRecord) == 32);
+
+struct FloatRecordLayout {
+  explicit FloatRecordLayout(const Particles& p) : records(p.size()) {
+    for (SizeT i = 0; i < p.size(); ++i) {
+      const Vectord& pos = p.pos(i);
+      const Vectord& vel = p.vel(i);
+      records[i] = {{float(pos[0]), float(pos[1]), float(pos[2])},
+                    {float(vel[0]), float(vel[1]), float(vel[2])},
+                    float(p.dty(i)),
+                    float(p.prs(i))};
+    }
+  }
+  HotFields operator[](const SizeT j) const {
+    const FloatRecord& r = records[j];
+    return {r.pos[0], r.pos[1], r.pos[2], r.vel[0],
+            r.vel[1], r.vel[2], r.dty,    r.prs};
+  }
+  std::vector<FloatRecord> records;
+};
+
+// the pressure force and the divergence of the velocity of the RHS
+template <typename Layout>
+void LayoutPairs(const Particles& p, const SavedNeighborsD& sn,
+                 const Layout& layout, std::vector<double>& res) {
+  const double h2 = math::tpow<2>(p.h());
+  ForEachParticle(p.size(), [&](const SizeT i) {
+    const HotFields a = layout[i];
+    double ax = 0., ay = 0., az = 0., div = 0.;
+    for (const SizeT j : sn.neighbors(i)) {
+      const HotFields b = layout[j];
+      const double rx = a.x - b.x, ry = a.y - b.y, rz = a.z - b.z;
+      const double w = 1. / (rx * rx + ry * ry + rz * rz + 0.01 * h2);
+      const double f = (a.prs + b.prs) / (a.dty * b.dty) * w;
+      ax += f * rx;
+      ay += f * ry;
+      az += f * rz;
+      div += ((a.vx - b.vx) * rx + (a.vy - b.vy) * ry + (a.vz - b.vz) * rz) *
+             w * b.dty;
+    }
+    res[i] = ax + ay + az + div;
+  });
+}
+}  // namespace
+
+template <typename Layout>
+static void Layout_Gather(benchmark::State& state) {
+  const Domain& d = PairsDomain(false);
+  const Layout layout(d.p);
+  std::vector<double> res(d.p.size());
+  for (auto _ : state) {
+    LayoutPairs(d.p, d.p_p_neighbors, layout, res);
+    benchmark::DoNotOptimize(res.data());
+  }
+  state.counters["interactions"] =
+      benchmark::Counter(NumPairs(d.p_p_neighbors, d.p.size()),
+                         benchmark::Counter::kIsIterationInvariantRate);
+}
+BENCHMARK(Layout_Gather<SeparateLayout>)->Unit(benchmark::kMillisecond);
+BENCHMARK(Layout_Gather<SoaLayout>)->Unit(benchmark::kMillisecond);
+BENCHMARK(Layout_Gather<RecordLayout>)->Unit(benchmark::kMillisecond);
+BENCHMARK(Layout_Gather<FloatRecordLayout>)->Unit(benchmark::kMillisecond);
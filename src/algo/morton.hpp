@@ -25,6 +25,7 @@
 
 #include <cstdint>
 
+#include "parstd/radix_sort.hpp"
 #include "utils/array.hpp"
 #include "utils/macros.hpp"
 #include "utils/types.hpp"
@@ -219,3 +220,11 @@ struct MortIdx {
     return morton < in.morton;
   }
 };
+
+template <typename morton_type, typename IndexType>
+struct RadixKey<MortIdx<morton_type, IndexType>> {
+  using key_type = typename morton_type::morton;
+  static key_type Get(const MortIdx<morton_type, IndexType>& m) {
+    return m.morton.value();
+  }
+};
@@ -32,9 +32,23 @@
 
 template <typename morton_type>
 MortonOctree<morton_type>::MortonOctree(GpuVector<morton_type> sorted_mortons) {
+  Build(sorted_mortons);
+}
+
+template <typename morton_type>
+void MortonOctree<morton_type>::Rebuild(
+    ScratchVector<morton_type>& sorted_mortons) {
+  Build(sorted_mortons);
+}
+
+template <typename morton_type>
+template <typename Mortons>
+void MortonOctree<morton_type>::Build(Mortons& sorted_mortons) {
+  depth_ = 0;
+  nodes_.clear();
   nodes_.reserve(2 * sorted_mortons.size());
   nodes_.resize(1);  // for root node
-  GpuVector<mort_id_t> mort_ids(sorted_mortons.size());
+  ScratchVector<mort_id_t> mort_ids(sorted_mortons.size());
   ForEachIndex(
       sorted_mortons.size(),
       [](const SizeT i, const morton_type* sorted_mortons,
@@ -46,12 +46,19 @@ class MortonOctree {
   MortonOctree() = default;
   MortonOctree(GpuVector<morton_type> sorted_mortons);
 
+  // Builds the tree of new mortons in the node memory of the current one.
+  // sorted_mortons is used as scratch memory.
+  void Rebuild(ScratchVector<morton_type>& sorted_mortons);
+
   SizeT operator[](const morton_type m) const;
 
   const GpuVector<Node>& nodes() const { return nodes_; }
   SizeT depth() const { return depth_; }
 
  private:
+  template <typename Mortons>
+  void Build(Mortons& sorted_mortons);
+
   static constexpr Node DefaultNode() {
     return Node{Invalid(), Invalid(), Invalid(), Invalid(),
                 Invalid(), Invalid(), Invalid(), Invalid()};
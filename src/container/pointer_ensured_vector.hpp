@@ -22,21 +22,223 @@
 
 #pragma once
 
+#include <omp.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <thread>
+#include <tuple>
+#include <utility>
 #include <vector>
 
+namespace internal {
+inline uint64_t NextPoolId() {
+  static std::atomic<uint64_t> next_id = 1;
+  return next_id++;
+}
+}  // namespace internal
+
+// Pool of objects with stable addresses, e.g. inflow buffers, probe records or
+// per-cell scratch created and released while the particles are processed.
+// The objects live in chunks of chunk_size slots, which are never moved or
+// freed before the pool is destroyed. Every thread allocates from its own
+// chunk and keeps its own free list, so only the allocation of a new chunk
+// takes the lock. A freed slot goes to the free list of the freeing thread.
+//
+// GetNewData and Free may be called concurrently, ForEach and the destructor
+// must not run concurrently with them.
 template <typename T>
 class PointerEnsuredVector {
+  // the object is the first member, so an object pointer is a slot pointer
+  struct Slot {
+    alignas(T) std::byte storage[sizeof(T)];
+    bool live = false;
+
+    T* object() { return std::launder(reinterpret_cast<T*>(storage)); }
+  };
+
+  struct alignas(64) ThreadSlots {
+    std::thread::id owner;
+    std::vector<Slot*> free;
+    Slot* next = nullptr;
+    Slot* end = nullptr;
+    // allocations minus frees of this thread, negative if it freed objects of
+    // other threads
+    int64_t live = 0;
+  };
+
  public:
-  T* GetNewData() {
-    if (data_.back().size() == data_.back().capacity()) {
-      data_.emplace_back();
-      data_.back().reserve(initCapacity);
+  static constexpr size_t default_chunk_size = 64;
+
+  explicit PointerEnsuredVector(const size_t chunk_size = default_chunk_size)
+      : chunk_size_(chunk_size), id_(internal::NextPoolId()) {
+    if (chunk_size_ == 0) {
+      throw std::runtime_error("PointerEnsuredVector: chunk size of zero");
+    }
+  }
+  ~PointerEnsuredVector() {
+    ForEachSlot([](Slot& s) {
+      if (s.live) s.object()->~T();
+    });
+  }
+
+  PointerEnsuredVector(const PointerEnsuredVector&) = delete;
+  PointerEnsuredVector& operator=(const PointerEnsuredVector&) = delete;
+
+  // Constructs an object from args in a free slot of the calling thread.
+  template <typename... Args>
+  T* GetNewData(Args&&... args) {
+    ThreadSlots& t = Local();
+    Slot* s = nullptr;
+    if (!t.free.empty()) {
+      s = t.free.back();
+      t.free.pop_back();
+    } else {
+      if (t.next == t.end) {
+        std::tie(t.next, t.end) = NewChunks(1);
+      }
+      s = t.next++;
     }
-    data_.back().emplace_back();
-    return &data_.back().back();
+    T* res = ::new (static_cast<void*>(s->storage))
+        T(std::forward<Args>(args)...);
+    s->live = true;
+    ++t.live;
+    return res;
   }
 
+  // Constructs n objects from args. The chunks missing after the free list and
+  // the current chunk of the thread are allocated at once.
+  template <typename... Args>
+  std::vector<T*> GetNewDataBulk(const size_t n, const Args&... args) {
+    ThreadSlots& t = Local();
+    std::vector<T*> res(n);
+    size_t k = 0;
+    const auto construct = [&](Slot* s) {
+      res[k++] = ::new (static_cast<void*>(s->storage)) T(args...);
+      s->live = true;
+    };
+    for (; k < n && !t.free.empty(); t.free.pop_back()) {
+      construct(t.free.back());
+    }
+    if (static_cast<size_t>(t.end - t.next) < n - k) {
+      const size_t missing = n - k - (t.end - t.next);
+      while (t.next != t.end) construct(t.next++);
+      std::tie(t.next, t.end) = NewChunks((missing - 1) / chunk_size_ + 1);
+    }
+    while (k < n) construct(t.next++);
+    t.live += n;
+    return res;
+  }
+
+  // Destroys the object and returns its slot to the calling thread.
+  void Free(T* p) {
+    Slot* s = reinterpret_cast<Slot*>(p);
+    p->~T();
+    s->live = false;
+    ThreadSlots& t = Local();
+    t.free.push_back(s);
+    --t.live;
+  }
+
+  // Calls f for every live object, in parallel over the chunks.
+  template <typename F>
+  void ForEach(F&& f) {
+    ForEachSlot([&f](Slot& s) {
+      if (s.live) f(*s.object());
+    });
+  }
+  template <typename F>
+  void ForEach(F&& f) const {
+    ForEachSlot([&f](Slot& s) {
+      if (s.live) f(std::as_const(*s.object()));
+    });
+  }
+
+  // number of live objects
+  size_t size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    int64_t res = 0;
+    for (const auto& t : threads_) {
+      res += t->live;
+    }
+    return res;
+  }
+  // number of slots in all chunks
+  size_t capacity() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return chunks_.size() * chunk_size_;
+  }
+  size_t chunk_size() const { return chunk_size_; }
+
  private:
-  static inline constexpr size_t initCapacity = 64;
-  std::vector<std::vector<T>> data_ = std::vector<std::vector<T>>(1);
-};
\ No newline at end of file
+  template <typename F>
+  void ForEachSlot(F&& f) const {
+    // chunks allocated at once are one block of slots
+    const size_t num_chunks = chunks_.size();
+#pragma omp parallel for schedule(dynamic)
+    for (size_t c = 0; c < num_chunks; ++c) {
+      Slot* chunk = chunks_[c];
+      for (size_t i = 0; i < chunk_size_; ++i) {
+        f(chunk[i]);
+      }
+    }
+  }
+
+  // allocates n consecutive chunks, returns the range of their slots
+  std::pair<Slot*, Slot*> NewChunks(const size_t n) {
+    // the storage of the slots stays uninitialized
+    std::unique_ptr<Slot[]> block(new Slot[n * chunk_size_]);
+    Slot* begin = block.get();
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (size_t c = 0; c < n; ++c) {
+      chunks_.push_back(begin + c * chunk_size_);
+    }
+    blocks_.push_back(std::move(block));
+    return {begin, begin + n * chunk_size_};
+  }
+
+  ThreadSlots& Local() {
+    // the id instead of the address identifies the pool, a new pool may be
+    // constructed at the address of a destroyed one. The ids are consecutive,
+    // so a thread alternating between a few pools hits a different entry for
+    // each of them.
+    struct Cache {
+      uint64_t pool_id = 0;
+      ThreadSlots* slots = nullptr;
+    };
+    thread_local std::array<Cache, num_cached_pools> caches;
+    Cache& cache = caches[id_ % num_cached_pools];
+    if (cache.pool_id != id_) {
+      const std::thread::id self = std::this_thread::get_id();
+      std::lock_guard<std::mutex> lock(mutex_);
+      const auto it =
+          std::find_if(threads_.begin(), threads_.end(),
+                       [self](const auto& t) { return t->owner == self; });
+      if (it != threads_.end()) {
+        cache = {id_, it->get()};
+      } else {
+        threads_.push_back(std::make_unique<ThreadSlots>());
+        threads_.back()->owner = self;
+        cache = {id_, threads_.back().get()};
+      }
+    }
+    return *cache.slots;
+  }
+
+  static constexpr size_t num_cached_pools = 16;
+
+  size_t chunk_size_;
+  uint64_t id_;
+
+  mutable std::mutex mutex_;
+  std::vector<std::unique_ptr<Slot[]>> blocks_;
+  std::vector<Slot*> chunks_;
+  std::vector<std::unique_ptr<ThreadSlots>> threads_;
+};
@@ -0,0 +1,179 @@
+// MIT License
+
+// Copyright (c) 2023 Marc Hartung
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "parstd/vector.hpp"
+#include "utils/array.hpp"
+#include "utils/macros.hpp"
+
+// Arrays of small vectors stored as structure of arrays, one GpuVector per
+// component. v[i] of a non-const SoaVector is a reference proxy which reads
+// and writes like an Array<T, N>&: it converts to the Array, is assigned and
+// updated with +=, -=, *= and /=, and enters the arithmetic of the Arrays.
+// Binding it to a const Array& copies the components. The per-element loops
+// over the component arrays of data(c) vectorize with one element per lane.
+template <typename T, size_t N>
+class SoaVector {
+ public:
+  using value_type = Array<T, N>;
+
+  class Reference {
+   public:
+    DEVICE Reference(SoaVector& v, const size_t i) : v_(v), i_(i) {}
+    Reference(const Reference&) = default;
+
+    DEVICE operator value_type() const {
+      value_type res;
+      value_type::template ForeachI<0>(
+          [&](const size_t c) { res[c] = v_.components_[c][i_]; });
+      return res;
+    }
+    DEVICE value_type value() const { return *this; }
+
+    // assigns the value, like the assignment through an Array&
+    DEVICE Reference& operator=(const value_type& a) {
+      value_type::template ForeachI<0>(
+          [&](const size_t c) { v_.components_[c][i_] = a[c]; });
+      return *this;
+    }
+    DEVICE Reference& operator=(const Reference& r) {
+      return *this = r.value();
+    }
+
+    DEVICE T& operator[](const size_t c) { return v_.components_[c][i_]; }
+    DEVICE const T& operator[](const size_t c) const {
+      return v_.components_[c][i_];
+    }
+
+    DEVICE Reference& operator+=(const value_type& a) {
+      return *this = value() + a;
+    }
+    DEVICE Reference& operator-=(const value_type& a) {
+      return *this = value() - a;
+    }
+    DEVICE Reference& operator*=(const T& a) { return *this = value() * a; }
+    DEVICE Reference& operator/=(const T& a) { return *this = value() / a; }
+
+    DEVICE value_type operator-() const { return -value(); }
+
+    // The arithmetic of the Arrays, the other operand may be an Array, a
+    // reference or a scalar where the Arrays take one.
+#define SOA_REFERENCE_OPERATOR(op)                                      \
+  template <typename B>                                                 \
+  DEVICE friend auto operator op(const Reference& a, const B& b) {      \
+    return a.value() op Value(b);                                       \
+  }                                                                     \
+  template <typename A>                                                 \
+    requires(!std::is_same_v<A, Reference>)                             \
+  DEVICE friend auto operator op(const A& a, const Reference& b) {      \
+    return a op b.value();                                              \
+  }
+    SOA_REFERENCE_OPERATOR(+)
+    SOA_REFERENCE_OPERATOR(-)
+    SOA_REFERENCE_OPERATOR(*)
+    SOA_REFERENCE_OPERATOR(/)
+#undef SOA_REFERENCE_OPERATOR
+
+   private:
+    template <typename B>
+    DEVICE static decltype(auto) Value(const B& b) {
+      if constexpr (std::is_same_v<B, Reference>) {
+        return b.value();
+      } else {
+        return (b);
+      }
+    }
+
+    SoaVector& v_;
+    const size_t i_;
+  };
+
+  using reference = Reference;
+  using const_reference = value_type;
+
+  SoaVector() = default;
+  explicit SoaVector(const size_t n, const value_type& val = value_type(T(0))) {
+    for (size_t c = 0; c < N; ++c) {
+      components_[c].assign(n, val[c]);
+    }
+  }
+  // Like GpuVector, it can be created from a host std::vector of the Arrays.
+  template <typename Allocator>
+  SoaVector(const std::vector<value_type, Allocator>& v) {
+    resize(v.size());
+#pragma omp parallel for schedule(static)
+    for (size_t i = 0; i < v.size(); ++i) {
+      (*this)[i] = v[i];
+    }
+  }
+
+  size_t size() const { return components_[0].size(); }
+  bool empty() const { return components_[0].empty(); }
+  void resize(const size_t n) {
+    for (GpuVector<T>& component : components_) {
+      component.resize(n);
+    }
+  }
+  void swap(SoaVector& other) { std::swap(components_, other.components_); }
+
+  Reference operator[](const size_t i) { return Reference(*this, i); }
+  value_type operator[](const size_t i) const {
+    value_type res;
+    value_type::template ForeachI<0>(
+        [&](const size_t c) { res[c] = components_[c][i]; });
+    return res;
+  }
+
+  // the array of component c
+  GpuVector<T>& component(const size_t c) { return components_[c]; }
+  const GpuVector<T>& component(const size_t c) const {
+    return components_[c];
+  }
+  T* data(const size_t c) { return components_[c].data(); }
+  const T* data(const size_t c) const { return components_[c].data(); }
+  // references to the component arrays, e.g. for FieldGather
+  auto components() {
+    return std::apply([](auto&... c) { return std::tie(c...); }, components_);
+  }
+
+ private:
+  std::array<GpuVector<T>, N> components_;
+};
+
+#ifndef GPU_ENABLED
+// Prints the pages per node of every component array in debug builds.
+template <typename T, size_t N>
+void ReportNumaPlacement(const std::string& name, const SoaVector<T, N>& v) {
+  for (size_t c = 0; c < N; ++c) {
+    ReportNumaPlacement(name + "[" + std::to_string(c) + "]", v.component(c));
+  }
+}
+#endif
@@ -30,12 +30,12 @@
 #include <vtkXMLPolyDataReader.h>
 #include <vtkXMLPolyDataWriter.h>
 
-void VTP::SetPoints(const std::vector<Vectord>& field) {
+void VTP::SetPoints(const Vectord* field, const size_t n) {
   auto vtk_points = vtkSmartPointer<vtkPoints>::New();
   vtk_points->SetDataTypeToDouble();
   auto vtk_vertices = vtkSmartPointer<vtkCellArray>::New();
   vtkIdType pid[1];
-  for (size_t i = 0; i != field.size(); i++) {
+  for (size_t i = 0; i != n; i++) {
     pid[0] = vtk_points->InsertNextPoint(field[i][0], field[i][1], field[i][2]);
     vtk_vertices->InsertNextCell(1, pid);
   }
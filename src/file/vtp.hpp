@@ -36,7 +36,7 @@ class VTP {
  public:
   VTP() = default;
 
-  void SetPoints(const std::vector<Vectord>& field);
+  void SetPoints(const Vectord* field, const size_t n);
 
   void SetMesh(const std::vector<Vectord>& points,
                const std::vector<Array<uint32_t, 3>>& segments);
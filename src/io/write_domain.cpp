@@ -23,16 +23,33 @@
 #include "write_domain.hpp"
 
 #include <iostream>
+#include <vector>
 
 #include "file/vtp.hpp"
 #include "wsph/particle_boundary.hpp"
 #include "wsph/particles.hpp"
 
+// the vectors as an array of Vectord, copied into buffer for the structure of
+// arrays layout
+static const Vectord* VectorData(const GpuVector<Vectord>& v,
+                                 std::vector<Vectord>&) {
+  return v.data();
+}
+static const Vectord* VectorData(const SoaVector<double, 3>& v,
+                                 std::vector<Vectord>& buffer) {
+  buffer.resize(v.size());
+  for (size_t i = 0; i < v.size(); ++i) {
+    buffer[i] = v[i];
+  }
+  return buffer.data();
+}
+
 void Write(const size_t output_num, const std::filesystem::path output_dir,
            const Particles& p) {
   VTP vtp;
-  vtp.SetPoints(p.pos());
-  vtp.AddPointData("velocity", p.vel().data(), p.size());
+  vtp.SetPoints(p.pos().points().data(), p.size());
+  std::vector<Vectord> vel;
+  vtp.AddPointData("velocity", VectorData(p.vel(), vel), p.size());
   vtp.AddPointData("density", p.dty().data(), p.size());
   vtp.AddPointData("pressure", p.prs().data(), p.size());
 
@@ -44,10 +61,11 @@ void Write(const size_t output_num, const std::filesystem::path output_dir,
 void Write(const size_t output_num, const std::filesystem::path output_dir,
            const ParticleBoundary& b) {
   VTP vtp;
-  vtp.SetPoints(b.pos());
+  vtp.SetPoints(b.pos().points().data(), b.size());
   const std::filesystem::path path =
       output_dir / ("solid_" + std::to_string(output_num) + ".vtp");
-  vtp.AddPointData("velocity", b.vel().data(), b.size());
+  std::vector<Vectord> vel;
+  vtp.AddPointData("velocity", VectorData(b.vel(), vel), b.size());
   vtp.AddPointData("density", b.dty().data(), b.size());
   vtp.AddPointData("pressure", b.prs().data(), b.size());
   vtp.AddPointData("normal", b.normal().data(), b.size());
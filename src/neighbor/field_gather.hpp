@@ -0,0 +1,99 @@
+// MIT License
+
+// Copyright (c) 2023 Marc Hartung
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <any>
+#include <cstddef>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "parstd/permute.hpp"
+#include "utils/types.hpp"
+
+// Reorders several per-particle fields in a single parallel pass over an index
+// map, fields[k][i] = fields_old[k][idx_map[i]]. Every field is gathered into
+// a persistent buffer of the same type, which is then swapped with the field,
+// so the old field memory becomes the buffer of the next reordering. With
+// PermutePolicy::kInPlace the fields are permuted without buffers instead.
+class FieldGather {
+ public:
+  FieldGather() = default;
+  // the buffers are a cache, copies start without them
+  FieldGather(const FieldGather&) {}
+  FieldGather& operator=(const FieldGather&) {
+    buffers_.clear();
+    return *this;
+  }
+  FieldGather(FieldGather&&) = default;
+  FieldGather& operator=(FieldGather&&) = default;
+
+  template <typename IndexMap, typename... T>
+  void operator()(const IndexMap& idx_map, GpuVector<T>&... fields) {
+    if (GetPermutePolicy() == PermutePolicy::kInPlace) {
+      buffers_.clear();
+      PermuteInPlace(idx_map, fields...);
+      return;
+    }
+    Gather(std::index_sequence_for<T...>(), idx_map, fields...);
+  }
+
+  // Gathers a tuple of field references, e.g. from std::tie.
+  template <typename IndexMap, typename... T>
+  void operator()(const IndexMap& idx_map,
+                  const std::tuple<GpuVector<T>&...>& fields) {
+    std::apply([&](auto&... f) { (*this)(idx_map, f...); }, fields);
+  }
+
+ private:
+  template <size_t... I, typename IndexMap, typename... T>
+  void Gather(std::index_sequence<I...>, const IndexMap& idx_map,
+              GpuVector<T>&... fields) {
+    const SizeT n = idx_map.size();
+    const std::tuple<GpuVector<T>*...> buffers(&Buffer<T>(I, n)...);
+    const std::tuple<T*...> trg(std::get<I>(buffers)->data()...);
+    const std::tuple<const T*...> src(fields.data()...);
+    const auto* idx = idx_map.data();
+#pragma omp parallel for schedule(static)
+    for (SizeT i = 0; i < n; ++i) {
+      const SizeT j = idx[i];
+      ((std::get<I>(trg)[i] = std::get<I>(src)[j]), ...);
+    }
+    (std::swap(*std::get<I>(buffers), fields), ...);
+  }
+
+  template <typename T>
+  GpuVector<T>& Buffer(const size_t k, const SizeT n) {
+    if (buffers_.size() <= k) {
+      buffers_.resize(k + 1);
+    }
+    GpuVector<T>* buffer = std::any_cast<GpuVector<T>>(&buffers_[k]);
+    if (buffer == nullptr) {
+      buffer = &buffers_[k].emplace<GpuVector<T>>();
+    }
+    buffer->resize(n);
+    return *buffer;
+  }
+
+  std::vector<std::any> buffers_;
+};
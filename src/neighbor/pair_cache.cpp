@@ -0,0 +1,102 @@
+// MIT License
+
+// Copyright (c) 2023 Marc Hartung
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "pair_cache.hpp"
+
+#include <omp.h>
+
+#include <algorithm>
+#include <cmath>
+
+#include "parstd/exclusive_scan.hpp"
+
+PairCostModel PairCostModel::Measure() {
+  PairCostModel res;
+  // larger than the last level caches of current cpus
+  constexpr size_t n = size_t(1) << 23;
+  GpuVector<double> a(n), b(n), c(n);
+#pragma omp parallel for schedule(static)
+  for (size_t i = 0; i < n; ++i) {
+    a[i] = 0.;
+    b[i] = 1.;
+    c[i] = 2.;
+  }
+  double best = 1.e30;
+  for (int rep = 0; rep < 3; ++rep) {
+    const double start = omp_get_wtime();
+#pragma omp parallel for schedule(static)
+    for (size_t i = 0; i < n; ++i) {
+      a[i] = b[i] + 0.5 * c[i];
+    }
+    best = std::min(best, omp_get_wtime() - start);
+  }
+  res.bytes_per_second = 3. * sizeof(double) * n / best;
+
+  constexpr size_t iterations = size_t(1) << 16;
+  double sink = 0.;
+  const double start = omp_get_wtime();
+#pragma omp parallel reduction(+ : sink)
+  {
+    // independent chains, so the latency of the square roots is hidden
+    double x[4] = {1., 2., 3., 4.};
+    for (size_t it = 0; it < iterations; ++it) {
+      for (double& v : x) {
+        v = std::sqrt(v * 1.0001 + 1.) / (v + 0.5) + 1.;
+      }
+    }
+    sink += x[0] + x[1] + x[2] + x[3];
+  }
+  const double elapsed = omp_get_wtime() - start;
+  // a multiplication, two additions, a square root and a division per value
+  constexpr double flops_per_value = 23.;
+  res.flops_per_second = 4. * flops_per_value * iterations *
+                         omp_get_max_threads() / elapsed;
+  if (sink == 0.) res.flops_per_second += 1.;
+  return res;
+}
+
+bool UsePairCache(const size_t num_reuses) {
+  switch (GetPairCachePolicy()) {
+    case PairCachePolicy::kOn:
+      return num_reuses > 0;
+    case PairCachePolicy::kOff:
+      return false;
+    default: {
+      static const PairCostModel model = PairCostModel::Measure();
+      return model.PreferCache(num_reuses);
+    }
+  }
+}
+
+void PairCache::Prepare(const SavedNeighborsD& neighbors) {
+  const SizeT n = neighbors.size();
+  counts_.resize(n + 1);
+  offsets_.resize(n + 1);
+#pragma omp parallel for schedule(static)
+  for (SizeT i = 0; i < n; ++i) {
+    counts_[i] = neighbors.neighbors(i).size();
+  }
+  counts_[n] = 0;
+  ExclusiveScan(counts_, offsets_, uint64_t{0});
+  pairs_.resize(offsets_[n]);
+  valid_ = false;
+}
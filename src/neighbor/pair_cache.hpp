@@ -0,0 +1,139 @@
+// MIT License
+
+// Copyright (c) 2023 Marc Hartung
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "parstd/ranges.hpp"
+#include "saved_neighbors.hpp"
+#include "utils/types.hpp"
+
+// Geometry of one pair of a neighbor list in 20 bytes: the unit vector and
+// the distance from the particle to its neighbor and the kernel gradient.
+struct PairGeometry {
+  Vectorf eij;
+  float dist;
+  float wg;
+
+  DEVICE Vectord rij() const {
+    return Vectord(eij[0], eij[1], eij[2]) * static_cast<double>(dist);
+  }
+};
+
+// Throughput of the machine for the decision between caching the pair
+// geometry and recomputing it. Recomputing costs the flops of rij, the
+// distance and the kernel gradient plus the read of the neighbor position,
+// caching the write of the geometry once and a read per reuse.
+struct PairCostModel {
+  // a square root or a division counts as 10 flops
+  static constexpr double recompute_flops = 45.;
+  static constexpr double recompute_bytes = sizeof(Vectord);
+
+  // all threads together
+  double bytes_per_second = 1.;
+  double flops_per_second = 1.;
+
+  // Measures a stream triad and independent square root and division chains
+  // on all threads, takes some 10ms.
+  static PairCostModel Measure();
+
+  // seconds per pair
+  double RecomputeTime() const {
+    return recompute_flops / flops_per_second +
+           recompute_bytes / bytes_per_second;
+  }
+  double CacheTime() const { return sizeof(PairGeometry) / bytes_per_second; }
+
+  // whether filling the cache and reading it num_reuses times is faster than
+  // recomputing the geometry for every reuse
+  bool PreferCache(const size_t num_reuses) const {
+    return num_reuses > 0 &&
+           (num_reuses + 1) * CacheTime() < num_reuses * RecomputeTime();
+  }
+};
+
+// The operators reading the cache use the float geometry instead of the
+// double one of the particle positions, so enabling the cache changes the
+// results by the float round-off. kOff, the default, keeps them reproducible.
+// kAuto decides with the PairCostModel of the machine, measured once per
+// process, so the decision and with it the round-off may differ between runs.
+enum class PairCachePolicy { kAuto, kOn, kOff };
+
+namespace internal {
+inline std::atomic<PairCachePolicy>& PairCachePolicyRef() {
+  static std::atomic<PairCachePolicy> policy = PairCachePolicy::kOff;
+  return policy;
+}
+}  // namespace internal
+
+inline PairCachePolicy GetPairCachePolicy() {
+  return internal::PairCachePolicyRef().load(std::memory_order_relaxed);
+}
+inline void SetPairCachePolicy(const PairCachePolicy policy) {
+  internal::PairCachePolicyRef().store(policy, std::memory_order_relaxed);
+}
+
+// Whether the geometry of a list is cached if num_reuses operators read it
+// after the one filling it.
+bool UsePairCache(const size_t num_reuses);
+
+// The pair geometry of a neighbor list for the operators sharing a particle
+// state. The first operator of the state fills it during its sweep, the
+// following ones read it instead of recomputing the geometry. Whoever moves
+// the particles invalidates it.
+class PairCache {
+ public:
+  using ConstRange = IteratorRange<const PairGeometry*>;
+
+  // Enables the cache if it pays off for num_reuses readers per fill.
+  void Plan(const size_t num_reuses) {
+    enabled_ = UsePairCache(num_reuses);
+    valid_ = false;
+  }
+  bool enabled() const { return enabled_; }
+  bool valid() const { return valid_; }
+  void Invalidate() { valid_ = false; }
+
+  // Sizes the cache for the pairs of neighbors. The filling operator writes
+  // the pairs of particle i to pairs(i) in the order of neighbors(i) and
+  // calls SetValid afterwards.
+  void Prepare(const SavedNeighborsD& neighbors);
+  void SetValid() { valid_ = true; }
+
+  PairGeometry* pairs(const SizeT i) { return pairs_.data() + offsets_[i]; }
+  ConstRange pairs(const SizeT i) const {
+    return ConstRange(pairs_.data() + offsets_[i],
+                      pairs_.data() + offsets_[i + 1]);
+  }
+
+  size_t num_pairs() const { return pairs_.size(); }
+
+ private:
+  bool enabled_ = false;
+  bool valid_ = false;
+  GpuVector<uint64_t> counts_;
+  GpuVector<uint64_t> offsets_;
+  GpuVector<PairGeometry> pairs_;
+};
@@ -24,6 +24,7 @@
 
 #include <atomic>
 #include <optional>
+#include <stdexcept>
 #include <tuple>
 #include <vector>
 
@@ -32,75 +33,46 @@
 #include "parstd/parstd.hpp"
 #include "utils/types.hpp"
 
-template <typename T>
-std::vector<T> ApplyIndexMap(const std::vector<SizeT>& idx_map,
-                             std::vector<T> v) {
-  std::vector<T> res(idx_map.size());
-#pragma omp for schedule(static)
-  for (size_t i = 0; i < idx_map.size(); ++i) {
-    res[i] = v[idx_map[i]];
-  }
-  return res;
-}
-
 class PointCellListD {
   using OctreeType = MortonOctree<Morton64>;
 
+  template <typename Points>
   static Coords GetCellListOffset(const double cell_size,
-                                  const std::vector<Vectord>& points) {
-    const Vectord min_p =
-        Reduce(points, Vectord(std::numeric_limits<double>::max()),
-               [](const Vectord a, const Vectord b) { return Min(a, b); });
+                                  const Points& points) {
+    const Vectord min_p = TransformReduce(
+        points.size(), Vectord(std::numeric_limits<double>::max()),
+        [](const Vectord a, const Vectord b) { return Min(a, b); },
+        [&points](const size_t i) { return points[i]; });
     return Coords(cell_size, -min_p) + 1;
   }
 
  public:
-  static std::tuple<std::vector<SizeT>, PointCellListD> Create(
-      const double cell_size, const std::vector<Vectord>& points) {
-    if (points.size() == 0)
-      return std::tuple<std::vector<SizeT>, PointCellListD>();
-
-    const Coords offset = GetCellListOffset(cell_size, points);
-    std::vector<MortIdx<Morton64>> mort_ids(points.size());
-#pragma omp for schedule(static)
-    for (SizeT i = 0; i < points.size(); ++i) {
-      mort_ids[i] = {Morton64(Coords(cell_size, points[i]) + offset), i};
-    }
-    Sort(mort_ids);
-    std::vector<SizeT> index_map(points.size());
-    std::vector<Vectord> sorted_points(points.size());
-#pragma omp for schedule(static)
-    for (SizeT i = 0; i < sorted_points.size(); ++i) {
-      sorted_points[i] = points[mort_ids[i].idx];
-      index_map[i] = mort_ids[i].idx;
-      mort_ids[i].idx = i;
-    }
-    Unique(mort_ids);
-    std::vector<SizeT> cell_starts(mort_ids.size() + 1);
-
-    std::vector<Morton64> mortons(mort_ids.size());
-#pragma omp for schedule(static)
-    for (SizeT i = 0; i < mort_ids.size(); ++i) {
-      cell_starts[i] = mort_ids[i].idx;
-      mortons[i] = mort_ids[i].morton;
-    }
-    cell_starts.back() = points.size();
-    OctreeType octree(std::move(mortons));
-
-    PointCellListD cell_list(cell_size, offset, std::move(sorted_points),
-                             std::move(cell_starts), std::move(octree));
-
-    return std::make_tuple(std::move(index_map), std::move(cell_list));
+  // The index map is scratch memory, it is valid until the end of the step.
+  template <typename Points>
+  static std::tuple<ScratchVector<SizeT>, PointCellListD> Create(
+      const double cell_size, const Points& points) {
+    PointCellListD res;
+    ScratchVector<SizeT> index_map = res.Build(cell_size, points);
+    return std::make_tuple(std::move(index_map), std::move(res));
   }
 
   static constexpr SizeT InvalidCellId() { return OctreeType::Invalid(); }
 
   PointCellListD() = default;
 
-  std::vector<SizeT> Update() {
-    std::vector<SizeT> res;
-    std::tie(res, *this) = Create(cell_size_, std::move(points_));
-    return res;
+  // Sorts the points into the cells of their new positions and returns the
+  // index map. All memory of the cell list is reused, with
+  // PermutePolicy::kInPlace the points are permuted without a scratch copy.
+  ScratchVector<SizeT> Update() {
+    if (GetPermutePolicy() == PermutePolicy::kInPlace) {
+      return Build(cell_size_, points_);
+    }
+    ScratchVector<Vectord> points(points_.size());
+#pragma omp parallel for schedule(static)
+    for (SizeT i = 0; i < points.size(); ++i) {
+      points[i] = points_[i];
+    }
+    return Build(cell_size_, points);
   }
 
   double cell_size() const { return cell_size_; }
@@ -114,7 +86,17 @@ class PointCellListD {
   }
   Vectord& operator[](const SizeT point_id) { return point(point_id); }
 
-  operator const std::vector<Vectord>&() const { return points_; }
+  const GpuVector<Vectord>& points() const { return points_; }
+
+  // Exchanges the positions with points of the same order, e.g. a second
+  // state buffer. The cells are not updated.
+  void SwapPoints(GpuVector<Vectord>& points) {
+    if (points.size() != points_.size()) {
+      throw std::runtime_error("PointCellListD: swapped points differ in size");
+    }
+    std::swap(points, points_);
+  }
+  operator const GpuVector<Vectord>&() const { return points_; }
 
   SizeT size() const { return num_points(); }
 
@@ -140,19 +122,59 @@ class PointCellListD {
   }
 
  private:
-  PointCellListD(const double cell_size, const Coords offset,
-                 std::vector<Vectord> points, std::vector<SizeT> cell_starts,
-                 OctreeType octree)
-      : cell_size_(cell_size),
-        offset_(offset),
-        points_(std::move(points)),
-        cell_starts_(std::move(cell_starts)),
-        octree_(std::move(octree)) {}
+  // Sorts the points into cells in the memory of the points, cell starts and
+  // octree of this list, the temporaries are scratch memory. points may be
+  // the points of this list, which are then permuted in place.
+  template <typename Points>
+  ScratchVector<SizeT> Build(const double cell_size, const Points& points) {
+    if (points.size() == 0) {
+      *this = PointCellListD();
+      return ScratchVector<SizeT>();
+    }
+    cell_size_ = cell_size;
+    offset_ = GetCellListOffset(cell_size, points);
+    ScratchVector<MortIdx<Morton64>> mort_ids(points.size());
+#pragma omp parallel for schedule(static)
+    for (SizeT i = 0; i < points.size(); ++i) {
+      mort_ids[i] = {Morton64(Coords(cell_size, points[i]) + offset_), i};
+    }
+    Sort(mort_ids);
+    ScratchVector<SizeT> index_map(points.size());
+    const SizeT num_points = points.size();
+    if (static_cast<const void*>(&points) == &points_) {
+#pragma omp parallel for schedule(static)
+      for (SizeT i = 0; i < num_points; ++i) {
+        index_map[i] = mort_ids[i].idx;
+        mort_ids[i].idx = i;
+      }
+      PermuteInPlace(index_map, points_);
+    } else {
+      points_.resize(num_points);
+#pragma omp parallel for schedule(static)
+      for (SizeT i = 0; i < num_points; ++i) {
+        points_[i] = points[mort_ids[i].idx];
+        index_map[i] = mort_ids[i].idx;
+        mort_ids[i].idx = i;
+      }
+    }
+    Unique(mort_ids);
+    cell_starts_.resize(mort_ids.size() + 1);
+
+    ScratchVector<Morton64> mortons(mort_ids.size());
+#pragma omp parallel for schedule(static)
+    for (SizeT i = 0; i < mort_ids.size(); ++i) {
+      cell_starts_[i] = mort_ids[i].idx;
+      mortons[i] = mort_ids[i].morton;
+    }
+    cell_starts_.back() = num_points;
+    octree_.Rebuild(mortons);
+    return index_map;
+  }
 
   double cell_size_ = std::numeric_limits<double>::max();
 
   Coords offset_ = Coords(0);
-  std::vector<Vectord> points_;
-  std::vector<SizeT> cell_starts_;
+  GpuVector<Vectord> points_;
+  GpuVector<SizeT> cell_starts_;
   OctreeType octree_;
 };
\ No newline at end of file
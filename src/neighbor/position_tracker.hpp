@@ -22,6 +22,8 @@
 
 #pragma once
 
+#include <functional>
+
 #include "parstd/parstd.hpp"
 #include "utils/types.hpp"
 
@@ -32,10 +34,13 @@ class PositionTracker {
       : max_dist_(max_dist), dists_(num_elements, 0.) {}
 
   bool MovedToFar() const {
-    return max_dist_ == 0. ||
-           Reduce(dists_, 0., [](const double acc, const double d) {
-             return std::max(acc, d);
-           });
+    const double* dists = dists_.data();
+    const double max_dist = max_dist_;
+    return max_dist == 0. ||
+           TransformReduce(dists_.size(), false, std::logical_or<>(),
+                           [dists, max_dist](const SizeT i) {
+                             return dists[i] > max_dist;
+                           });
   }
   void Reset(const SizeT num_to_track) {
     // ForEachIndex(dists_.size(),[])
@@ -22,6 +22,11 @@
 
 #include "saved_neighbors.hpp"
 
+#include "parstd/parallel_for.hpp"
+
+// cells of splashes hold few particles, so the cost per cell varies strongly
+constexpr size_t cell_grain = 4;
+
 template <bool IsSameList>
 void SavedNeighborsD::RecomputeNeighbors(const PointCellListD& src_list,
                                          const PointCellListD& trg_list) {
@@ -37,8 +42,7 @@ void SavedNeighborsD::RecomputeNeighbors(const PointCellListD& src_list,
       neighbors_[i].clear();
     }
     const double dist2 = math::tpow<2>(src_list.cell_size());
-#pragma omp parallel for schedule(guided)
-    for (SizeT ci = 0; ci < src_list.num_cells(); ++ci) {
+    const auto cell_neighbors = [&](const SizeT ci) {
       SizeT nncells = 0;
       std::array<SizeT, 27> cell_ids_;
       const Coords own_coords = src_list.cell_coords(ci);
@@ -63,9 +67,12 @@ void SavedNeighborsD::RecomputeNeighbors(const PointCellListD& src_list,
           }
         }
       }
-    }
+    };
+    ParallelFor(IndexRange<SizeT>(src_list.num_cells()), cell_grain,
+                cell_neighbors);
   }
 }
+
 SavedNeighborsD::SavedNeighborsD(const PointCellListD& point_list) {
   RecomputeNeighbors<true>(point_list, point_list);
 }
@@ -61,5 +61,5 @@ class SavedNeighborsD {
   void RecomputeNeighbors(const PointCellListD& src_list,
                           const PointCellListD& trg_list);
 
-  std::vector<std::vector<SizeT>> neighbors_;
+  GpuVector<std::vector<SizeT>> neighbors_;
 };
\ No newline at end of file
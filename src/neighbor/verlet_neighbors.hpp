@@ -57,5 +57,5 @@ class VerletNeighborsD {
                           const PointCellListD& trg_list);
 
   SavedNeighborsD saved_;
-  std::vector<SizeT> num_active_;
+  GpuVector<SizeT> num_active_;
 };
\ No newline at end of file
@@ -26,15 +26,36 @@
 #include "vector.hpp"
 
 #ifndef GPU_ENABLED
+#if defined(OMP_ENABLED) && !defined(TBB_ENABLED)
+#include "internal/omp_algorithms.hpp"
+
+namespace internal {
+using omp::exclusive_scan;
+}
+#else
 #include <numeric>
 
 namespace internal {
 using std::exclusive_scan;
 }
+#endif
 #else
-#include <thrust/fill.h>
+#include <thrust/scan.h>
 
 namespace internal {
 using thrust::exclusive_scan;
 }
 #endif
+
+template <typename T>
+void ExclusiveScan(const GpuVector<T>& v, GpuVector<T>& v_out, const T init) {
+  internal::exclusive_scan(std_exec_policy(), v.begin(), v.end(),
+                           v_out.begin(), init);
+}
+
+template <typename T, typename BinaryOp>
+void ExclusiveScan(const GpuVector<T>& v, GpuVector<T>& v_out, const T init,
+                   BinaryOp op) {
+  internal::exclusive_scan(std_exec_policy(), v.begin(), v.end(),
+                           v_out.begin(), init, op);
+}
@@ -0,0 +1,295 @@
+// MIT License
+
+// Copyright (c) 2023 Marc Hartung
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "execution_config.hpp"
+
+#include <omp.h>
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <tuple>
+
+struct AppliedConfig {
+  ExecutionConfig config;
+  std::vector<int> pinned_cpus;
+  bool applied = false;
+};
+
+static AppliedConfig& Applied() {
+  static AppliedConfig applied;
+  return applied;
+}
+
+static int ReadTopologyValue(const int cpu, const std::string& name,
+                             const int fallback) {
+  std::ifstream in("/sys/devices/system/cpu/cpu" + std::to_string(cpu) +
+                   "/topology/" + name);
+  int value = fallback;
+  if (in) in >> value;
+  return value;
+}
+
+static const char* Name(const PinPolicy pinning) {
+  switch (pinning) {
+    case PinPolicy::kCompact:
+      return "compact";
+    case PinPolicy::kScatter:
+      return "scatter";
+    case PinPolicy::kOnePerCore:
+      return "core";
+    default:
+      return "none";
+  }
+}
+
+static const char* Name(const NumaPolicy numa) {
+  switch (numa) {
+    case NumaPolicy::kFirstTouch:
+      return "first_touch";
+    case NumaPolicy::kInterleave:
+      return "interleave";
+    default:
+      return "none";
+  }
+}
+
+static const char* Name(const PermutePolicy permute) {
+  return permute == PermutePolicy::kInPlace ? "in_place" : "gather";
+}
+
+static const char* Name(const SimdIsa isa) {
+  switch (isa) {
+    case SimdIsa::kAvx2:
+      return "avx2";
+    case SimdIsa::kAvx512:
+      return "avx512";
+    default:
+      return "scalar";
+  }
+}
+
+static void PinThread(const int cpu) {
+#ifdef __linux__
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  sched_setaffinity(0, sizeof(set), &set);
+#endif
+}
+
+ExecutionConfig ExecutionConfig::FromEnvironment() {
+  ExecutionConfig res;
+  if (const char* nt = std::getenv("GAFS_NUM_THREADS")) {
+    res.num_threads = std::atoi(nt);
+    if (res.num_threads < 0) {
+      throw std::runtime_error("GAFS_NUM_THREADS: must not be negative");
+    }
+  }
+  if (const char* pin = std::getenv("GAFS_PINNING")) {
+    const std::string p(pin);
+    if (p == "none") {
+      res.pinning = PinPolicy::kNone;
+    } else if (p == "compact") {
+      res.pinning = PinPolicy::kCompact;
+    } else if (p == "scatter") {
+      res.pinning = PinPolicy::kScatter;
+    } else if (p == "core") {
+      res.pinning = PinPolicy::kOnePerCore;
+    } else {
+      throw std::runtime_error("GAFS_PINNING: unknown policy " + p);
+    }
+  }
+  if (const char* smt = std::getenv("GAFS_SMT")) {
+    res.use_smt = std::string(smt) != "0";
+  }
+  if (const char* numa = std::getenv("GAFS_NUMA")) {
+    const std::string n(numa);
+    if (n == "none") {
+      res.numa = NumaPolicy::kNone;
+    } else if (n == "first_touch") {
+      res.numa = NumaPolicy::kFirstTouch;
+    } else if (n == "interleave") {
+      res.numa = NumaPolicy::kInterleave;
+    } else {
+      throw std::runtime_error("GAFS_NUMA: unknown policy " + n);
+    }
+  }
+  if (const char* huge = std::getenv("GAFS_HUGEPAGES")) {
+    res.huge_pages = std::string(huge) != "0";
+  }
+  if (const char* permute = std::getenv("GAFS_PERMUTE")) {
+    const std::string p(permute);
+    if (p == "gather") {
+      res.permute = PermutePolicy::kGather;
+    } else if (p == "in_place") {
+      res.permute = PermutePolicy::kInPlace;
+    } else {
+      throw std::runtime_error("GAFS_PERMUTE: unknown policy " + p);
+    }
+  }
+  if (const char* simd = std::getenv("GAFS_SIMD")) {
+    const std::string s(simd);
+    if (s == "scalar") {
+      res.simd = SimdIsa::kScalar;
+    } else if (s == "avx2") {
+      res.simd = SimdIsa::kAvx2;
+    } else if (s == "avx512") {
+      res.simd = SimdIsa::kAvx512;
+    } else {
+      throw std::runtime_error("GAFS_SIMD: unknown instruction set " + s);
+    }
+  }
+  if (const char* prefetch = std::getenv("GAFS_PREFETCH")) {
+    res.prefetch_distance = std::atoi(prefetch);
+    if (res.prefetch_distance < 0) {
+      throw std::runtime_error("GAFS_PREFETCH: must not be negative");
+    }
+  }
+  return res;
+}
+
+std::vector<CpuInfo> DetectCpus() {
+  std::vector<CpuInfo> res;
+#ifdef __linux__
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+      if (CPU_ISSET(cpu, &set)) {
+        res.push_back({cpu, ReadTopologyValue(cpu, "physical_package_id", 0),
+                       ReadTopologyValue(cpu, "core_id", cpu)});
+      }
+    }
+  }
+#endif
+  if (res.empty()) {
+    for (int cpu = 0; cpu < omp_get_num_procs(); ++cpu) {
+      res.push_back({cpu, 0, cpu});
+    }
+  }
+  return res;
+}
+
+std::vector<int> PinnedCpus(const std::vector<CpuInfo>& cpus,
+                            const PinPolicy pinning, const bool use_smt) {
+  if (pinning == PinPolicy::kNone) return {};
+
+  // rank of the core within its package and of the cpu within its core
+  std::map<int, std::set<int>> package_cores;
+  std::map<std::pair<int, int>, std::set<int>> core_cpus;
+  for (const CpuInfo& c : cpus) {
+    package_cores[c.package].insert(c.core);
+    core_cpus[{c.package, c.core}].insert(c.id);
+  }
+  const auto rank = [](const std::set<int>& s, const int v) -> int {
+    return std::distance(s.begin(), s.find(v));
+  };
+  // (sort key, cpu id)
+  std::vector<std::tuple<std::tuple<int, int, int>, int>> order;
+  for (const CpuInfo& c : cpus) {
+    const int core = rank(package_cores[c.package], c.core),
+              sibling = rank(core_cpus[{c.package, c.core}], c.id);
+    if (sibling > 0 && (!use_smt || pinning == PinPolicy::kOnePerCore)) {
+      continue;
+    }
+    if (pinning == PinPolicy::kScatter) {
+      order.push_back({{sibling, core, c.package}, c.id});
+    } else {
+      order.push_back({{c.package, core, sibling}, c.id});
+    }
+  }
+  std::sort(order.begin(), order.end());
+  std::vector<int> res;
+  for (const auto& o : order) {
+    res.push_back(std::get<1>(o));
+  }
+  return res;
+}
+
+void ApplyExecutionConfig(const ExecutionConfig& config) {
+  const std::vector<int> pinned =
+      PinnedCpus(DetectCpus(), config.pinning, config.use_smt);
+  // without an explicit count or pinning OMP_NUM_THREADS stays in effect
+  int num_threads = config.num_threads;
+  if (num_threads == 0 && !pinned.empty()) num_threads = pinned.size();
+  if (num_threads > 0) {
+    omp_set_dynamic(0);
+    omp_set_num_threads(num_threads);
+  }
+  if (!pinned.empty()) {
+#pragma omp parallel num_threads(num_threads)
+    PinThread(pinned[omp_get_thread_num() % pinned.size()]);
+  }
+  SetNumaPolicy(config.numa);
+  SetHugePages(config.huge_pages);
+  SetPermutePolicy(config.permute);
+  SetSimdIsa(config.simd);
+  SetPrefetchDistance(config.prefetch_distance);
+  Applied() = {config, pinned, true};
+}
+
+std::string ExecutionReport() {
+  const std::vector<CpuInfo> cpus = DetectCpus();
+  std::set<int> packages;
+  std::set<std::pair<int, int>> cores;
+  for (const CpuInfo& c : cpus) {
+    packages.insert(c.package);
+    cores.insert({c.package, c.core});
+  }
+  const AppliedConfig& applied = Applied();
+  std::stringstream res;
+  res << "topology: " << packages.size() << " sockets | " << cores.size()
+      << " cores | " << cpus.size() << " hw threads | "
+      << internal::NumNumaNodes() << " numa nodes\n";
+  res << "threads: " << omp_get_max_threads()
+      << " | pinning: " << Name(applied.config.pinning)
+      << " | smt: " << (applied.config.use_smt ? "on" : "off")
+      << " | numa: " << Name(GetNumaPolicy())
+      << " | huge pages: " << (GetHugePages() ? "on" : "off")
+      << " | permute: " << Name(GetPermutePolicy())
+      << " | simd: " << Name(GetSimdIsa())
+      << " | prefetch: " << GetPrefetchDistance();
+  if (!applied.pinned_cpus.empty()) {
+    res << " | cpus:";
+    const size_t n = std::min<size_t>(omp_get_max_threads(),
+                                      applied.pinned_cpus.size());
+    for (size_t i = 0; i < n; ++i) {
+      res << " " << applied.pinned_cpus[i];
+    }
+    if (static_cast<size_t>(omp_get_max_threads()) > n) {
+      res << " (oversubscribed)";
+    }
+  }
+  if (!applied.applied) {
+    res << " (OpenMP defaults)";
+  }
+  res << "\n";
+  return res.str();
+}
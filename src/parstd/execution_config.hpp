@@ -0,0 +1,87 @@
+// MIT License
+
+// Copyright (c) 2023 Marc Hartung
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "numa_allocator.hpp"
+#include "permute.hpp"
+#include "prefetch.hpp"
+#include "simd.hpp"
+
+// Placement of the threads on the cpus of the process' affinity mask:
+// kCompact fills the cores of one socket after the other, kScatter alternates
+// between the sockets and kOnePerCore uses one hardware thread of every core.
+enum class PinPolicy { kNone, kCompact, kScatter, kOnePerCore };
+
+struct ExecutionConfig {
+  // 0 uses the OpenMP default, or all selected cpus when pinning
+  int num_threads = 0;
+  PinPolicy pinning = PinPolicy::kNone;
+  // whether SMT siblings are used for kCompact and kScatter
+  bool use_smt = true;
+  // page placement of GpuVectors allocated afterwards
+  NumaPolicy numa = NumaPolicy::kFirstTouch;
+  // transparent huge pages for GpuVectors of 2MB and more
+  bool huge_pages = true;
+  // reordering of the particle fields after a cell list update
+  PermutePolicy permute = PermutePolicy::kGather;
+  // widest instruction set of the particle loops, capped to the cpu
+  SimdIsa simd = SimdIsa::kAvx512;
+  // iterations the scalar pair loops prefetch ahead, 0 disables it
+  int prefetch_distance = 0;
+
+  // Reads GAFS_NUM_THREADS, GAFS_PINNING (none, compact, scatter or core),
+  // GAFS_SMT (0 or 1), GAFS_NUMA (none, first_touch or interleave),
+  // GAFS_HUGEPAGES (0 or 1), GAFS_PERMUTE (gather or in_place), GAFS_SIMD
+  // (scalar, avx2 or avx512) and GAFS_PREFETCH (the prefetch distance). Unset
+  // variables keep the defaults.
+  static ExecutionConfig FromEnvironment();
+};
+
+struct CpuInfo {
+  int id = 0;
+  int package = 0;
+  int core = 0;
+};
+
+// The cpus the process may run on, with the socket and core they belong to.
+std::vector<CpuInfo> DetectCpus();
+
+// The cpus the threads are pinned to in the order of the thread ids. Empty for
+// PinPolicy::kNone.
+std::vector<int> PinnedCpus(const std::vector<CpuInfo>& cpus,
+                            const PinPolicy pinning, const bool use_smt);
+
+// Sets the number of OpenMP threads, pins them and sets the NumaPolicy, the
+// huge page usage, the PermutePolicy, the SimdIsa and the prefetch distance.
+// Everything in parstd runs on the OpenMP thread team, including the
+// ParallelFor scheduler, so the configuration applies to all parallel loops.
+// Dynamic team sizes are disabled, so the pinned threads are reused by all
+// following regions.
+void ApplyExecutionConfig(const ExecutionConfig& config);
+
+// Describes the topology and the applied configuration, e.g. for the log at
+// startup.
+std::string ExecutionReport();
@@ -27,14 +27,20 @@
 #include <functional>
 #include <vector>
 
+#include "vector.hpp"
+
 #ifdef OMP_ENABLED
 #include <omp.h>
 #endif
 
 template <typename T>
 struct IsStdVector : public std::false_type {};
+template <typename T, typename Allocator>
+struct IsStdVector<std::vector<T, Allocator>> : public std::true_type {};
+#ifndef GPU_ENABLED
 template <typename T>
-struct IsStdVector<std::vector<T>> : public std::true_type {};
+struct IsStdVector<GpuVector<T>> : public std::true_type {};
+#endif
 
 template <typename... Args>
 struct ContainsStdVector {
@@ -55,7 +61,7 @@ template <typename Functor, typename... Args>
 std::enable_if_t<ContainsStdVector<Args...>::value, void> ForEachIndex(
     size_t n, Functor device_func, Args&&... args) {
 #ifdef OMP_ENABLED
-#pragma omp parallel for schedule(static) num_threads(omp_get_max_threads())
+#pragma omp parallel for schedule(static)
   for (size_t i = 0; i < n; ++i) {
     device_func(i, ConvertToPointerStd(args)...);
   }
@@ -103,7 +103,15 @@ class CpuStdVector {
     }
   }
 
-  void resize(const size_t n) { resize(n, T()); }
+  // trivial types are left uninitialized like in GpuVector, see NumaAllocator
+  void resize(const size_t n) {
+    if constexpr (std::is_trivially_default_constructible_v<T>) {
+      reserve(n);
+      sz_ = n;
+    } else {
+      resize(n, T());
+    }
+  }
 
   MemoryContainer release() {
     MemoryContainer res = std::move(mem_);
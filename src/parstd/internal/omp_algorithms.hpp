@@ -0,0 +1,322 @@
+// MIT License
+
+// Copyright (c) 2023 Marc Hartung
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+// OpenMP backends for the parstd algorithms. They are used instead of the
+// std::execution overloads when TBB is not available, in which case the std
+// library only provides sequential implementations. The signatures mirror the
+// std algorithms including the (ignored) execution policy, so the parstd
+// wrappers can switch between them with a using declaration. All algorithms
+// expect random access iterators over contiguous memory.
+
+#include <omp.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <numeric>
+#include <vector>
+
+namespace internal {
+namespace omp {
+
+// below this number of elements per thread the sequential algorithm is used
+inline constexpr size_t min_chunk_size = 1 << 14;
+
+inline size_t NumChunks(const size_t n) {
+  const size_t max_chunks = std::max<size_t>(1, n / min_chunk_size);
+  return std::min<size_t>(omp_get_max_threads(), max_chunks);
+}
+
+// first index of chunk c, when n elements are split into nc chunks
+inline size_t ChunkBegin(const size_t n, const size_t nc, const size_t c) {
+  return (n / nc) * c + std::min(c, n % nc);
+}
+
+// Merge path: returns the number of elements of a among the first diag
+// elements of the merge of the sorted ranges a and b. It is found by a binary
+// search along the cross diagonal diag of the merge matrix. Equal elements of a
+// are taken first, like std::merge does.
+template <typename It1, typename It2, typename Compare>
+size_t MergePathSplit(It1 a, const size_t na, It2 b, const size_t nb,
+                      const size_t diag, Compare comp) {
+  size_t lo = (diag > nb) ? diag - nb : 0, hi = std::min(diag, na);
+  while (lo < hi) {
+    const size_t mid = lo + (hi - lo) / 2;
+    if (!comp(b[diag - mid - 1], a[mid])) {
+      lo = mid + 1;
+    } else {
+      hi = mid;
+    }
+  }
+  return lo;
+}
+
+// Merges part `part` of `num_parts` of the sorted ranges a and b. The output is
+// cut into parts of equal size and the matching inputs are found by the merge
+// path, so all parts can be merged independently and are equally expensive,
+// regardless of how the values of a and b interleave.
+template <typename It1, typename It2, typename OutIt, typename Compare>
+void MergePart(It1 a, const size_t na, It2 b, const size_t nb, OutIt out,
+               Compare comp, const size_t num_parts, const size_t part) {
+  const size_t ob = ChunkBegin(na + nb, num_parts, part),
+               oe = ChunkBegin(na + nb, num_parts, part + 1);
+  const size_t ia_b = MergePathSplit(a, na, b, nb, ob, comp),
+               ia_e = MergePathSplit(a, na, b, nb, oe, comp);
+  std::merge(a + ia_b, a + ia_e, b + (ob - ia_b), b + (oe - ia_e), out + ob,
+             comp);
+}
+
+// Reduces transform_op(i) for all indices i in [0, n). It is not a std
+// algorithm, but the base of transform_reduce and also used with TBB, since the
+// std algorithms need iterators which can be dereferenced to an lvalue.
+template <typename T, typename BinaryOp, typename IndexOp>
+T index_transform_reduce(const size_t n, T init, BinaryOp reduce_op,
+                         IndexOp transform_op) {
+  const size_t nc = NumChunks(n);
+  if (nc == 1) {
+    for (size_t i = 0; i < n; ++i) {
+      init = reduce_op(init, transform_op(i));
+    }
+    return init;
+  }
+  std::vector<T> partial(nc, init);
+#pragma omp parallel for schedule(static, 1)
+  for (size_t c = 0; c < nc; ++c) {
+    const size_t b = ChunkBegin(n, nc, c), e = ChunkBegin(n, nc, c + 1);
+    T acc = transform_op(b);
+    for (size_t i = b + 1; i < e; ++i) {
+      acc = reduce_op(acc, transform_op(i));
+    }
+    partial[c] = acc;
+  }
+  T res = init;
+  for (const T& p : partial) {
+    res = reduce_op(res, p);
+  }
+  return res;
+}
+
+template <typename ExecPolicy, typename It, typename T, typename BinaryOp,
+          typename UnaryOp>
+T transform_reduce(ExecPolicy&&, It first, It last, T init, BinaryOp reduce_op,
+                   UnaryOp transform_op) {
+  const auto transform_idx = [first, &transform_op](const size_t i) {
+    return transform_op(first[i]);
+  };
+  return omp::index_transform_reduce(std::distance(first, last), init,
+                                     reduce_op, transform_idx);
+}
+
+template <typename ExecPolicy, typename It, typename T, typename BinaryOp>
+T reduce(ExecPolicy&& policy, It first, It last, T init, BinaryOp op) {
+  return omp::transform_reduce(policy, first, last, init, op,
+                               [](const auto& v) -> T { return v; });
+}
+
+template <typename ExecPolicy, typename It, typename T>
+T reduce(ExecPolicy&& policy, It first, It last, T init) {
+  return omp::reduce(policy, first, last, init, std::plus<>());
+}
+
+template <typename ExecPolicy, typename It>
+typename std::iterator_traits<It>::value_type reduce(ExecPolicy&& policy,
+                                                     It first, It last) {
+  using T = typename std::iterator_traits<It>::value_type;
+  return omp::reduce(policy, first, last, T{}, std::plus<>());
+}
+
+template <typename ExecPolicy, typename It, typename OutIt, typename T,
+          typename BinaryOp>
+OutIt exclusive_scan(ExecPolicy&&, It first, It last, OutIt d_first, T init,
+                     BinaryOp op) {
+  const size_t n = std::distance(first, last), nc = NumChunks(n);
+  if (nc == 1) {
+    return std::exclusive_scan(first, last, d_first, init, op);
+  }
+  std::vector<T> offsets(nc + 1, init);
+#pragma omp parallel for schedule(static, 1)
+  for (size_t c = 0; c < nc; ++c) {
+    const size_t b = ChunkBegin(n, nc, c), e = ChunkBegin(n, nc, c + 1);
+    T acc = first[b];
+    for (size_t i = b + 1; i < e; ++i) {
+      acc = op(acc, first[i]);
+    }
+    offsets[c + 1] = acc;
+  }
+  for (size_t c = 0; c < nc; ++c) {
+    offsets[c + 1] = op(offsets[c], offsets[c + 1]);
+  }
+#pragma omp parallel for schedule(static, 1)
+  for (size_t c = 0; c < nc; ++c) {
+    const size_t b = ChunkBegin(n, nc, c), e = ChunkBegin(n, nc, c + 1);
+    T acc = offsets[c];
+    for (size_t i = b; i < e; ++i) {
+      const T v = first[i];  // in and output may alias
+      d_first[i] = acc;
+      acc = op(acc, v);
+    }
+  }
+  return d_first + n;
+}
+
+template <typename ExecPolicy, typename It, typename OutIt, typename T>
+OutIt exclusive_scan(ExecPolicy&& policy, It first, It last, OutIt d_first,
+                     T init) {
+  return omp::exclusive_scan(policy, first, last, d_first, init,
+                             std::plus<>());
+}
+
+template <typename ExecPolicy, typename It, typename BinaryPredicate>
+It unique(ExecPolicy&&, It first, It last, BinaryPredicate pred) {
+  using T = typename std::iterator_traits<It>::value_type;
+  const size_t n = std::distance(first, last), nc = NumChunks(n);
+  if (nc == 1) {
+    return std::unique(first, last, pred);
+  }
+  const auto keep = [first, pred](const size_t i) {
+    return i == 0 || !pred(first[i - 1], first[i]);
+  };
+  std::vector<size_t> offsets(nc + 1, 0);
+#pragma omp parallel for schedule(static, 1)
+  for (size_t c = 0; c < nc; ++c) {
+    const size_t b = ChunkBegin(n, nc, c), e = ChunkBegin(n, nc, c + 1);
+    size_t num_keep = 0;
+    for (size_t i = b; i < e; ++i) {
+      num_keep += keep(i);
+    }
+    offsets[c + 1] = num_keep;
+  }
+  std::inclusive_scan(offsets.begin(), offsets.end(), offsets.begin());
+
+  // compaction can not be done in place, since chunks write into the input
+  // range of their predecessors
+  std::vector<T> compacted(offsets.back());
+#pragma omp parallel for schedule(static, 1)
+  for (size_t c = 0; c < nc; ++c) {
+    const size_t b = ChunkBegin(n, nc, c), e = ChunkBegin(n, nc, c + 1);
+    size_t k = offsets[c];
+    for (size_t i = b; i < e; ++i) {
+      if (keep(i)) compacted[k++] = first[i];
+    }
+  }
+  const size_t nk = compacted.size(), nck = NumChunks(nk);
+#pragma omp parallel for schedule(static, 1)
+  for (size_t c = 0; c < nck; ++c) {
+    const size_t b = ChunkBegin(nk, nck, c), e = ChunkBegin(nk, nck, c + 1);
+    std::move(compacted.begin() + b, compacted.begin() + e, first + b);
+  }
+  return first + nk;
+}
+
+template <typename ExecPolicy, typename It>
+It unique(ExecPolicy&& policy, It first, It last) {
+  return omp::unique(policy, first, last, std::equal_to<>());
+}
+
+template <typename ExecPolicy, typename It1, typename It2, typename OutIt,
+          typename Compare>
+OutIt merge(ExecPolicy&&, It1 first1, It1 last1, It2 first2, It2 last2,
+            OutIt d_first, Compare comp) {
+  const size_t na = std::distance(first1, last1),
+               nb = std::distance(first2, last2), np = NumChunks(na + nb);
+  if (np == 1) {
+    return std::merge(first1, last1, first2, last2, d_first, comp);
+  }
+#pragma omp parallel for schedule(static, 1)
+  for (size_t p = 0; p < np; ++p) {
+    MergePart(first1, na, first2, nb, d_first, comp, np, p);
+  }
+  return d_first + (na + nb);
+}
+
+template <typename ExecPolicy, typename It1, typename It2, typename OutIt>
+OutIt merge(ExecPolicy&& policy, It1 first1, It1 last1, It2 first2, It2 last2,
+            OutIt d_first) {
+  return omp::merge(policy, first1, last1, first2, last2, d_first,
+                    std::less<>());
+}
+
+// Sorts one chunk per thread and merges the sorted runs pairwise. Every merge
+// round is split into as many independent parts as there are threads, so also
+// the last rounds with only a few runs left use all threads.
+template <typename ExecPolicy, typename It, typename Compare>
+void sort(ExecPolicy&&, It first, It last, Compare comp) {
+  using T = typename std::iterator_traits<It>::value_type;
+  const size_t n = std::distance(first, last), nc = NumChunks(n);
+  if (nc == 1) {
+    std::sort(first, last, comp);
+    return;
+  }
+  std::vector<size_t> runs(nc + 1);
+  for (size_t c = 0; c <= nc; ++c) {
+    runs[c] = ChunkBegin(n, nc, c);
+  }
+#pragma omp parallel for schedule(static, 1)
+  for (size_t c = 0; c < nc; ++c) {
+    std::sort(first + runs[c], first + runs[c + 1], comp);
+  }
+
+  std::vector<T> buffer(n);
+  T *src = std::addressof(*first), *trg = buffer.data();
+  const size_t num_threads = omp_get_max_threads();
+  while (runs.size() > 2) {
+    const size_t num_pairs = runs.size() / 2,
+                 parts_per_pair = (num_threads + num_pairs - 1) / num_pairs;
+#pragma omp parallel for schedule(dynamic, 1)
+    for (size_t k = 0; k < num_pairs * parts_per_pair; ++k) {
+      const size_t pair = k / parts_per_pair, part = k % parts_per_pair;
+      const size_t b = runs[2 * pair], m = runs[std::min(2 * pair + 1,
+                                                         runs.size() - 1)],
+                   e = runs[std::min(2 * pair + 2, runs.size() - 1)];
+      MergePart(src + b, m - b, src + m, e - m, trg + b, comp, parts_per_pair,
+                part);
+    }
+    std::vector<size_t> merged_runs;
+    for (size_t r = 0; r < runs.size(); r += 2) {
+      merged_runs.push_back(runs[r]);
+    }
+    if (merged_runs.back() != n) {
+      merged_runs.push_back(n);
+    }
+    runs = std::move(merged_runs);
+    std::swap(src, trg);
+  }
+  if (src != std::addressof(*first)) {
+#pragma omp parallel for schedule(static, 1)
+    for (size_t c = 0; c < nc; ++c) {
+      const size_t b = ChunkBegin(n, nc, c), e = ChunkBegin(n, nc, c + 1);
+      std::move(src + b, src + e, first + b);
+    }
+  }
+}
+
+template <typename ExecPolicy, typename It>
+void sort(ExecPolicy&& policy, It first, It last) {
+  omp::sort(policy, first, last, std::less<>());
+}
+
+}  // namespace omp
+}  // namespace internal
@@ -26,11 +26,19 @@
 #include "vector.hpp"
 
 #ifndef GPU_ENABLED
+#if defined(OMP_ENABLED) && !defined(TBB_ENABLED)
+#include "internal/omp_algorithms.hpp"
+
+namespace internal {
+using omp::merge;
+}
+#else
 #include <algorithm>
 
 namespace internal {
 using std::merge;
 }
+#endif
 #else
 #include <thrust/merge.h>
 
@@ -0,0 +1,309 @@
+// MIT License
+
+// Copyright (c) 2023 Marc Hartung
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <omp.h>
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// kFirstTouch places the pages of large allocations on the node of the thread
+// which processes them in `#pragma omp parallel for schedule(static)` loops,
+// kInterleave spreads them round robin over all nodes.
+enum class NumaPolicy { kNone, kFirstTouch, kInterleave };
+
+namespace internal {
+inline std::atomic<NumaPolicy>& NumaPolicyRef() {
+  static std::atomic<NumaPolicy> policy = NumaPolicy::kFirstTouch;
+  return policy;
+}
+
+inline std::atomic<bool>& HugePagesRef() {
+  static std::atomic<bool> huge_pages = true;
+  return huge_pages;
+}
+
+inline constexpr size_t numa_page_size = 4096;
+// smaller allocations are left to operator new
+inline constexpr size_t numa_min_bytes = 16 * numa_page_size;
+// transparent huge page size on x86-64 and most aarch64 kernels
+inline constexpr size_t huge_page_size = size_t(2) << 20;
+
+// Mapped allocations start at one of num_colours offsets of colour_bytes into
+// their mapping. Otherwise all large fields start at the same offset modulo
+// 4kB, and the loops which stream several fields of the same element size
+// suffer from 4K aliasing of their loads and stores.
+inline constexpr size_t colour_bytes = 256;
+inline constexpr size_t num_colours = numa_page_size / colour_bytes;
+
+// Mappings leave room for the largest colour offset. Those of at least one
+// huge page are rounded up to and aligned at the huge page size, independent
+// of whether huge pages are requested, so the length passed to munmap follows
+// from the allocation size alone.
+inline size_t MappedBytes(const size_t bytes) {
+  const size_t padded = bytes + numa_page_size;
+  if (bytes < huge_page_size) {
+    return padded;
+  }
+  return (padded + huge_page_size - 1) / huge_page_size * huge_page_size;
+}
+
+// Offset of the next mapped allocation into its mapping.
+inline size_t NextColourOffset() {
+  static std::atomic<size_t> colour = 0;
+  return colour.fetch_add(1, std::memory_order_relaxed) % num_colours *
+         colour_bytes;
+}
+
+inline int NumNumaNodes() {
+  static const int num_nodes = [] {
+    int n = 0;
+    while (std::filesystem::exists("/sys/devices/system/node/node" +
+                                   std::to_string(n))) {
+      ++n;
+    }
+    return std::max(n, 1);
+  }();
+  return num_nodes;
+}
+
+#ifdef __linux__
+inline void* MapPages(const size_t bytes, const bool huge_pages) {
+  if (bytes < huge_page_size) {
+    return mmap(nullptr, MappedBytes(bytes), PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  }
+  // over-allocate by one huge page and cut off both ends to align the mapping
+  const size_t mapped = MappedBytes(bytes);
+  const size_t padded = mapped + huge_page_size;
+  void* p = mmap(nullptr, padded, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (p == MAP_FAILED) {
+    return p;
+  }
+  const uintptr_t begin = reinterpret_cast<uintptr_t>(p),
+                  aligned = (begin + huge_page_size - 1) / huge_page_size *
+                            huge_page_size;
+  if (aligned > begin) {
+    munmap(p, aligned - begin);
+  }
+  if (aligned + mapped < begin + padded) {
+    munmap(reinterpret_cast<void*>(aligned + mapped),
+           begin + padded - aligned - mapped);
+  }
+  void* res = reinterpret_cast<void*>(aligned);
+  if (huge_pages) {
+    madvise(res, mapped, MADV_HUGEPAGE);
+  }
+  return res;
+}
+#endif
+
+inline void InterleavePages(void* p, const size_t bytes) {
+#ifdef __linux__
+  constexpr int mpol_interleave = 3;
+  const int num_nodes = std::min(NumNumaNodes(), 64);
+  const unsigned long node_mask =
+      (num_nodes == 64) ? ~0ul : (1ul << num_nodes) - 1;
+  syscall(SYS_mbind, p, bytes, mpol_interleave, &node_mask, 65, 0);
+#endif
+}
+
+// Writes one byte of every page, partitioned among the threads like a static
+// schedule over the n elements of size element_size, so every page is placed
+// on the node of the thread which processes its first element. The page of
+// the first element is touched by the first thread.
+inline void FirstTouchPages(void* p, const size_t n,
+                            const size_t element_size) {
+  const uintptr_t base = reinterpret_cast<uintptr_t>(p);
+#pragma omp parallel
+  {
+    const size_t tid = omp_get_thread_num(), nt = omp_get_num_threads();
+    const size_t chunk = (n + nt - 1) / nt;
+    const size_t eb = std::min(n, tid * chunk), ee = std::min(n, eb + chunk);
+    const uintptr_t end = base + ee * element_size;
+    uintptr_t page = (base + eb * element_size + numa_page_size - 1) /
+                     numa_page_size * numa_page_size;
+    if (eb == 0 && ee > 0) {
+      *reinterpret_cast<char*>(base) = 0;
+      page = base / numa_page_size * numa_page_size + numa_page_size;
+    }
+    for (; page < end; page += numa_page_size) {
+      *reinterpret_cast<char*>(page) = 0;
+    }
+  }
+}
+}  // namespace internal
+
+inline NumaPolicy GetNumaPolicy() {
+  return internal::NumaPolicyRef().load(std::memory_order_relaxed);
+}
+inline void SetNumaPolicy(const NumaPolicy policy) {
+  internal::NumaPolicyRef().store(policy, std::memory_order_relaxed);
+}
+
+// Whether allocations of at least 2MB are backed by transparent huge pages,
+// which removes most TLB misses of the neighbor loops over large fields.
+inline bool GetHugePages() {
+  return internal::HugePagesRef().load(std::memory_order_relaxed);
+}
+inline void SetHugePages(const bool huge_pages) {
+  internal::HugePagesRef().store(huge_pages, std::memory_order_relaxed);
+}
+
+// Allocator which places the pages of large allocations according to the
+// NumaPolicy at the time of the allocation. They are mapped directly, so the
+// pages are fresh and their placement is decided by the first touch. Mappings
+// of 2MB and more are aligned for transparent huge pages. The allocations are
+// staggered by a colour offset of less than 4kB into their mappings. With huge
+// pages the first touch decides the placement per 2MB instead of per 4kB.
+//
+// Elements constructed without arguments are default-initialized, so resize()
+// and the size constructor do not fill trivial types like double or Vectord.
+// All fields are written by the kernels before they are read. Note that the
+// thrust::device_vector of GPU builds does value-initialize.
+template <typename T>
+class NumaAllocator {
+ public:
+  using value_type = T;
+
+  NumaAllocator() = default;
+  template <typename U>
+  NumaAllocator(const NumaAllocator<U>&) {}
+
+  T* allocate(const size_t n) {
+    static_assert(alignof(T) <= internal::colour_bytes);
+    const size_t bytes = n * sizeof(T);
+#ifdef __linux__
+    if (bytes >= internal::numa_min_bytes) {
+      void* p = internal::MapPages(bytes, GetHugePages());
+      if (p == MAP_FAILED) {
+        throw std::bad_alloc();
+      }
+      const NumaPolicy policy = GetNumaPolicy();
+      if (policy == NumaPolicy::kInterleave) {
+        internal::InterleavePages(p, internal::MappedBytes(bytes));
+      }
+      p = static_cast<char*>(p) + internal::NextColourOffset();
+      if (policy == NumaPolicy::kFirstTouch && !omp_in_parallel()) {
+        // inside of a parallel region the allocating thread is the user
+        internal::FirstTouchPages(p, n, sizeof(T));
+      }
+      return static_cast<T*>(p);
+    }
+#endif
+    return static_cast<T*>(::operator new(bytes, std::align_val_t(alignof(T))));
+  }
+
+  void deallocate(T* p, const size_t n) {
+#ifdef __linux__
+    const size_t bytes = n * sizeof(T);
+    if (bytes >= internal::numa_min_bytes) {
+      // the colour offset is less than a page into the page aligned mapping
+      const uintptr_t mapping = reinterpret_cast<uintptr_t>(p) /
+                                internal::numa_page_size *
+                                internal::numa_page_size;
+      munmap(reinterpret_cast<void*>(mapping), internal::MappedBytes(bytes));
+      return;
+    }
+#endif
+    ::operator delete(p, std::align_val_t(alignof(T)));
+  }
+
+  template <typename U>
+  void construct(U* p) noexcept(std::is_nothrow_default_constructible_v<U>) {
+    if constexpr (std::is_trivially_default_constructible_v<U>) {
+      ::new (static_cast<void*>(p)) U;
+    } else {
+      ::new (static_cast<void*>(p)) U();
+    }
+  }
+  template <typename U, typename... Args>
+  void construct(U* p, Args&&... args) {
+    ::new (static_cast<void*>(p)) U(std::forward<Args>(args)...);
+  }
+
+  template <typename U>
+  bool operator==(const NumaAllocator<U>&) const {
+    return true;
+  }
+  template <typename U>
+  bool operator!=(const NumaAllocator<U>&) const {
+    return false;
+  }
+};
+
+// Number of pages of [p, p + bytes) per NUMA node. Pages which were never
+// touched are not counted. Empty if the placement can not be queried.
+inline std::vector<size_t> NumaPagesPerNode(const void* p, const size_t bytes) {
+  std::vector<size_t> res;
+#ifdef __linux__
+  const size_t page_size = sysconf(_SC_PAGESIZE);
+  const uintptr_t first = reinterpret_cast<uintptr_t>(p) / page_size,
+                  last = (reinterpret_cast<uintptr_t>(p) + bytes + page_size -
+                          1) / page_size;
+  std::vector<void*> pages;
+  for (uintptr_t page = first; page < last; ++page) {
+    pages.push_back(reinterpret_cast<void*>(page * page_size));
+  }
+  std::vector<int> status(pages.size(), -1);
+  if (pages.empty() || syscall(SYS_move_pages, 0, pages.size(), pages.data(),
+                               nullptr, status.data(), 0) != 0) {
+    return res;
+  }
+  res.resize(internal::NumNumaNodes(), 0);
+  for (const int node : status) {
+    if (node >= 0 && static_cast<size_t>(node) < res.size()) ++res[node];
+  }
+#endif
+  return res;
+}
+
+// Prints the pages per node of a container in debug builds. A diagnostic for
+// tests and benchmarks, the solver does not report the placement.
+template <typename Container>
+void ReportNumaPlacement(const std::string& name, const Container& c) {
+#ifndef NDEBUG
+  const std::vector<size_t> pages =
+      NumaPagesPerNode(c.data(), c.size() * sizeof(*c.data()));
+  std::cerr << "numa pages " << name << ":";
+  for (size_t node = 0; node < pages.size(); ++node) {
+    std::cerr << " node" << node << "=" << pages[node];
+  }
+  std::cerr << (pages.empty() ? " unknown\n" : "\n");
+#endif
+}
@@ -1,3 +1,19 @@
+#pragma once
+
+#include <omp.h>
+
+#include <algorithm>
+#include <cmath>
+#include <concepts>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <vector>
+
+#include "execution.hpp"
+#include "internal/omp_algorithms.hpp"
+#include "vector.hpp"
+
 template <typename T>
 void SortParallelMerge(std::vector<T>& data) {
   constexpr size_t thread_fac = 8;
@@ -66,4 +82,97 @@ void SortParallelMerge(std::vector<T>& data) {
     std::copy(recv_data[tid].begin(), recv_data[tid].begin() + (e - b),
               data.begin() + b);
   }
-}
\ No newline at end of file
+}
+
+namespace internal {
+inline constexpr size_t sample_oversampling = 32;
+}  // namespace internal
+
+// Merges the sorted ranges a and b into res, which must have the size of both.
+// The output is split into one equally sized part per thread by the merge
+// path, see internal::omp::MergePathSplit.
+template <typename T, typename A1, typename A2, typename A3,
+          typename Compare = std::less<>>
+void MergeParallel(const std::vector<T, A1>& a, const std::vector<T, A2>& b,
+                   std::vector<T, A3>& res, Compare comp = Compare()) {
+  internal::omp::merge(std_exec_policy(), a.begin(), a.end(), b.begin(),
+                       b.end(), res.begin(), comp);
+}
+
+// Parallel sample sort. Splitters are chosen from an oversampled, sorted set of
+// evenly spaced samples, every thread counts and scatters its chunk into one
+// bucket per thread and finally the buckets are sorted independently. Only
+// comp is used on the values, so it works with any type and comparator. The
+// sort is not stable. The buckets are scattered into scratch, which is resized
+// to the size of data and can be kept by the caller for repeated sorts.
+template <typename T, typename A1, typename A2, typename Compare = std::less<>>
+void SortParallelSample(std::vector<T, A1>& data, std::vector<T, A2>& scratch,
+                        Compare comp = Compare()) {
+  const size_t n = data.size(), nb = internal::omp::NumChunks(n);
+  if (nb == 1) {
+    std::sort(data.begin(), data.end(), comp);
+    return;
+  }
+  const size_t num_samples = nb * internal::sample_oversampling;
+  std::vector<T> samples(num_samples);
+  for (size_t i = 0; i < num_samples; ++i) {
+    samples[i] = data[i * (n / num_samples)];
+  }
+  std::sort(samples.begin(), samples.end(), comp);
+  std::vector<T> splitters(nb - 1);
+  for (size_t i = 1; i < nb; ++i) {
+    splitters[i - 1] = samples[i * internal::sample_oversampling];
+  }
+  const auto bucket = [&splitters, &comp](const T& v) -> size_t {
+    return std::upper_bound(splitters.begin(), splitters.end(), v, comp) -
+           splitters.begin();
+  };
+
+  // offsets[c * nb + k]: position of the first value of chunk c in bucket k
+  std::vector<size_t> offsets(nb * nb, 0), bucket_starts(nb + 1, 0);
+  scratch.resize(n);
+#pragma omp parallel for schedule(static, 1)
+  for (size_t c = 0; c < nb; ++c) {
+    const size_t b = internal::omp::ChunkBegin(n, nb, c),
+                 e = internal::omp::ChunkBegin(n, nb, c + 1);
+    for (size_t i = b; i < e; ++i) {
+      ++offsets[c * nb + bucket(data[i])];
+    }
+  }
+  size_t sum = 0;
+  for (size_t k = 0; k < nb; ++k) {
+    bucket_starts[k] = sum;
+    for (size_t c = 0; c < nb; ++c) {
+      const size_t count = offsets[c * nb + k];
+      offsets[c * nb + k] = sum;
+      sum += count;
+    }
+  }
+  bucket_starts[nb] = sum;
+#pragma omp parallel for schedule(static, 1)
+  for (size_t c = 0; c < nb; ++c) {
+    const size_t b = internal::omp::ChunkBegin(n, nb, c),
+                 e = internal::omp::ChunkBegin(n, nb, c + 1);
+    size_t* offset = offsets.data() + c * nb;
+    for (size_t i = b; i < e; ++i) {
+      scratch[offset[bucket(data[i])]++] = data[i];
+    }
+  }
+  // buckets differ in size for skewed data, hence the dynamic schedule
+#pragma omp parallel for schedule(dynamic, 1)
+  for (size_t k = 0; k < nb; ++k) {
+    const auto kb = scratch.begin() + bucket_starts[k],
+               ke = scratch.begin() + bucket_starts[k + 1];
+    std::sort(kb, ke, comp);
+    std::copy(kb, ke, data.begin() + bucket_starts[k]);
+  }
+}
+
+// SortParallelSample with a scratch buffer which is released on return.
+template <typename T, typename Allocator, typename Compare = std::less<>>
+  requires std::predicate<Compare&, const T&, const T&>
+void SortParallelSample(std::vector<T, Allocator>& data,
+                        Compare comp = Compare()) {
+  GpuVector<T> scratch;
+  SortParallelSample(data, scratch, comp);
+}
@@ -0,0 +1,221 @@
+// MIT License
+
+// Copyright (c) 2023 Marc Hartung
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <omp.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+#include "ranges.hpp"
+
+enum class Schedule { kWorkStealing, kGuided, kDynamic };
+
+namespace internal {
+inline std::atomic<Schedule>& ParallelForScheduleRef() {
+  static std::atomic<Schedule> schedule = Schedule::kWorkStealing;
+  return schedule;
+}
+}  // namespace internal
+
+// The schedule used by all ParallelFor loops. It is a global setting, so the
+// schedulers can be compared on the loops of a complete simulation.
+inline Schedule GetParallelForSchedule() {
+  return internal::ParallelForScheduleRef().load(std::memory_order_relaxed);
+}
+inline void SetParallelForSchedule(const Schedule schedule) {
+  internal::ParallelForScheduleRef().store(schedule,
+                                           std::memory_order_relaxed);
+}
+
+// Per thread statistics of one ParallelFor call. Busy is the time from the
+// start of the loop until the thread ran out of work, the difference to the
+// slowest thread is the time spent waiting at the closing barrier.
+struct ParallelForStats {
+  size_t num_threads() const { return busy.size(); }
+
+  double MaxBusy() const {
+    return busy.empty() ? 0. : *std::max_element(busy.begin(), busy.end());
+  }
+  double MeanBusy() const {
+    double sum = 0.;
+    for (const double b : busy) sum += b;
+    return busy.empty() ? 0. : sum / busy.size();
+  }
+  // max over mean busy time, 1 for a perfectly balanced loop
+  double Imbalance() const {
+    const double mean = MeanBusy();
+    return (mean > 0.) ? MaxBusy() / mean : 1.;
+  }
+  size_t TotalSteals() const {
+    size_t sum = 0;
+    for (const size_t s : steals) sum += s;
+    return sum;
+  }
+
+  std::vector<double> busy;
+  std::vector<size_t> steals;
+  std::vector<size_t> work;
+};
+
+namespace internal {
+
+class SpinLock {
+ public:
+  void lock() {
+    while (flag_.test_and_set(std::memory_order_acquire)) {
+      while (flag_.test(std::memory_order_relaxed)) {
+      }
+    }
+  }
+  void unlock() { flag_.clear(std::memory_order_release); }
+
+ private:
+  std::atomic_flag flag_ = ATOMIC_FLAG_INIT;
+};
+
+// The remaining indices of one thread. The owner takes grain sized chunks from
+// the front, thieves split off the back half, so a range acts as a deque whose
+// entries are only materialized when they are stolen.
+class alignas(64) StealableRange {
+ public:
+  void Set(const size_t b, const size_t e) {
+    lock_.lock();
+    begin_ = b;
+    end_ = e;
+    lock_.unlock();
+  }
+
+  bool Pop(const size_t grain, size_t& b, size_t& e) {
+    lock_.lock();
+    const bool res = begin_ != end_;
+    b = begin_;
+    e = begin_ = std::min(end_, begin_ + grain);
+    lock_.unlock();
+    return res;
+  }
+
+  // only steals if more than one chunk is left, the owner processes the rest
+  bool Steal(const size_t grain, size_t& b, size_t& e) {
+    lock_.lock();
+    const bool res = end_ - begin_ > grain;
+    if (res) {
+      b = begin_ + (end_ - begin_) / 2;
+      e = end_;
+      end_ = b;
+    }
+    lock_.unlock();
+    return res;
+  }
+
+ private:
+  SpinLock lock_;
+  size_t begin_ = 0;
+  size_t end_ = 0;
+};
+
+template <typename IndexType, typename Functor>
+void WorkStealingFor(const IndexRange<IndexType> range, const size_t grain,
+                     Functor& f, ParallelForStats& stats) {
+  const size_t n = range.size();
+  std::vector<StealableRange> ranges(stats.num_threads());
+#pragma omp parallel num_threads(ranges.size())
+  {
+    const size_t tid = omp_get_thread_num(), nt = omp_get_num_threads();
+    ranges[tid].Set(n * tid / nt, n * (tid + 1) / nt);
+#pragma omp barrier
+    const double start = omp_get_wtime();
+    size_t b, e;
+    while (true) {
+      while (ranges[tid].Pop(grain, b, e)) {
+        for (size_t i = b; i < e; ++i) {
+          f(range[i]);
+        }
+        stats.work[tid] += e - b;
+      }
+      // a thread which is stolen from is still working, so its remaining
+      // chunks are processed even if the search fails
+      bool stolen = false;
+      for (size_t k = 1; k < nt && !stolen; ++k) {
+        stolen = ranges[(tid + k) % nt].Steal(grain, b, e);
+      }
+      if (!stolen) break;
+      ++stats.steals[tid];
+      ranges[tid].Set(b, e);
+    }
+    stats.busy[tid] = omp_get_wtime() - start;
+  }
+}
+
+template <typename IndexType, typename Functor>
+void OmpFor(const IndexRange<IndexType> range, const size_t grain,
+            const Schedule schedule, Functor& f, ParallelForStats& stats) {
+  const size_t n = range.size();
+#pragma omp parallel num_threads(stats.num_threads())
+  {
+    const size_t tid = omp_get_thread_num();
+    const double start = omp_get_wtime();
+    size_t work = 0;
+    if (schedule == Schedule::kGuided) {
+#pragma omp for schedule(guided, grain) nowait
+      for (size_t i = 0; i < n; ++i) {
+        f(range[i]);
+        ++work;
+      }
+    } else {
+#pragma omp for schedule(dynamic, grain) nowait
+      for (size_t i = 0; i < n; ++i) {
+        f(range[i]);
+        ++work;
+      }
+    }
+    stats.work[tid] = work;
+    stats.busy[tid] = omp_get_wtime() - start;
+  }
+}
+
+}  // namespace internal
+
+// Calls f(i) for all i in range in parallel. Work is handed out in chunks of
+// grain indices, the schedule is set by SetParallelForSchedule. Intended for
+// loops with strongly varying cost per index, e.g. per cell loops in domains
+// with splashes, where static schedules balance badly.
+template <typename IndexType, typename Functor>
+void ParallelFor(const IndexRange<IndexType> range, const size_t grain,
+                 Functor f, ParallelForStats* stats = nullptr) {
+  ParallelForStats local_stats;
+  ParallelForStats& s = (stats) ? *stats : local_stats;
+  const size_t nt = omp_get_max_threads();
+  s.busy.assign(nt, 0.);
+  s.steals.assign(nt, 0);
+  s.work.assign(nt, 0);
+  if (range.empty()) return;
+  const size_t chunk = std::max<size_t>(grain, 1);
+  if (GetParallelForSchedule() == Schedule::kWorkStealing) {
+    internal::WorkStealingFor(range, chunk, f, s);
+  } else {
+    internal::OmpFor(range, chunk, GetParallelForSchedule(), f, s);
+  }
+}
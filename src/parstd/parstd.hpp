@@ -25,10 +25,15 @@
 #include "enumerate.hpp"
 #include "exclusive_scan.hpp"
 #include "execution.hpp"
+#include "execution_config.hpp"
 #include "fill.hpp"
 #include "for_each_index.hpp"
 #include "merge.hpp"
+#include "parallel_for.hpp"
+#include "permute.hpp"
+#include "radix_sort.hpp"
 #include "reduce.hpp"
+#include "simd.hpp"
 #include "sort.hpp"
 #include "unique.hpp"
 #include "vector.hpp"
\ No newline at end of file
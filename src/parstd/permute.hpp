@@ -0,0 +1,142 @@
+// MIT License
+
+// Copyright (c) 2023 Marc Hartung
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <omp.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+// kGather reorders fields through a second buffer of every field, kInPlace
+// follows the cycles of the permutation and needs one bit per element, at the
+// cost of random writes and a lower parallel efficiency for long cycles.
+enum class PermutePolicy { kGather, kInPlace };
+
+namespace internal {
+inline std::atomic<PermutePolicy>& PermutePolicyRef() {
+  static std::atomic<PermutePolicy> policy = PermutePolicy::kGather;
+  return policy;
+}
+
+// Atomically marks element i, true if it was not marked before.
+inline bool Claim(std::vector<uint64_t>& bits, const size_t i) {
+  const uint64_t mask = uint64_t(1) << (i % 64);
+  return (std::atomic_ref<uint64_t>(bits[i / 64]).fetch_or(
+              mask, std::memory_order_relaxed) &
+          mask) == 0;
+}
+}  // namespace internal
+
+inline PermutePolicy GetPermutePolicy() {
+  return internal::PermutePolicyRef().load(std::memory_order_relaxed);
+}
+inline void SetPermutePolicy(const PermutePolicy policy) {
+  internal::PermutePolicyRef().store(policy, std::memory_order_relaxed);
+}
+
+// fields[k][i] = fields_old[k][idx_map[i]] for every field, in place.
+//
+// Every thread walks the cycles from the start indices of its static chunk
+// and claims each element in a visited bitset. A walk which returns to its
+// start owns the whole cycle and rotates it right away. A walk which runs into
+// an element claimed by another thread owns a chain of the cycle, the element
+// it ran into is the start of the next chain. The chains are shifted after all
+// walks finished, each takes the saved first value of its successor chain.
+template <typename IndexMap, typename... Fields>
+void PermuteInPlace(const IndexMap& idx_map, Fields&... fields) {
+  const size_t n = idx_map.size();
+  std::vector<uint64_t> visited((n + 63) / 64, 0);
+  const auto* idx = idx_map.data();
+  const std::tuple<decltype(fields.data())...> data(fields.data()...);
+
+  const auto move_element = [&data](const size_t trg, const size_t src) {
+    std::apply([=](auto*... d) { ((d[trg] = std::move(d[src])), ...); },
+               data);
+  };
+  const auto take_element = [&data](const size_t i) {
+    return std::apply(
+        [i](auto*... d) { return std::tuple(std::move(d[i])...); }, data);
+  };
+  // shifts the values along the cycle from start on until the element whose
+  // successor is end, which gets the values of last
+  const auto shift = [&](const size_t start, const size_t end, auto&& last) {
+    size_t cur = start;
+    while (static_cast<size_t>(idx[cur]) != end) {
+      move_element(cur, idx[cur]);
+      cur = idx[cur];
+    }
+    std::apply(
+        [&](auto*... d) {
+          std::apply([&](auto&... l) { ((d[cur] = std::move(l)), ...); },
+                     last);
+        },
+        data);
+  };
+
+  // open chains as (start, start of the successor chain) per thread, ordered
+  // by start since the static chunks are ordered by thread id
+  std::vector<std::vector<std::pair<size_t, size_t>>> thread_chains(
+      omp_get_max_threads());
+#pragma omp parallel num_threads(thread_chains.size())
+  {
+    auto& chains = thread_chains[omp_get_thread_num()];
+#pragma omp for schedule(static)
+    for (size_t s = 0; s < n; ++s) {
+      if (!internal::Claim(visited, s)) continue;
+      size_t cur = s;
+      while (internal::Claim(visited, idx[cur])) {
+        cur = idx[cur];
+      }
+      const size_t end = idx[cur];
+      if (end == s) {
+        if (cur != s) shift(s, s, take_element(s));
+      } else {
+        chains.emplace_back(s, end);
+      }
+    }
+  }
+
+  std::vector<std::pair<size_t, size_t>> chains;
+  for (const auto& c : thread_chains) {
+    chains.insert(chains.end(), c.begin(), c.end());
+  }
+  if (chains.empty()) return;
+  std::vector<std::tuple<typename Fields::value_type...>> first(chains.size());
+#pragma omp parallel for schedule(static)
+  for (size_t c = 0; c < chains.size(); ++c) {
+    first[c] = take_element(chains[c].first);
+  }
+#pragma omp parallel for schedule(dynamic)
+  for (size_t c = 0; c < chains.size(); ++c) {
+    const size_t next =
+        std::lower_bound(chains.begin(), chains.end(),
+                         std::pair<size_t, size_t>(chains[c].second, 0)) -
+        chains.begin();
+    shift(chains[c].first, chains[c].second, first[next]);
+  }
+}
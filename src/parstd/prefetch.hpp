@@ -0,0 +1,56 @@
+// MIT License
+
+// Copyright (c) 2023 Marc Hartung
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+
+// Software prefetching of the indirect loops, e.g. the pair loops which read
+// the fields of the neighbors through the neighbor indices. The hardware
+// prefetchers follow strided streams but not the neighbor indices, so the
+// loops request the data of the iteration distance steps ahead.
+
+namespace internal {
+inline std::atomic<int>& PrefetchDistanceRef() {
+  static std::atomic<int> distance = 0;
+  return distance;
+}
+}  // namespace internal
+
+// The number of iterations the indirect loops prefetch ahead, 0 disables the
+// prefetching.
+inline int GetPrefetchDistance() {
+  return internal::PrefetchDistanceRef().load(std::memory_order_relaxed);
+}
+inline void SetPrefetchDistance(const int distance) {
+  internal::PrefetchDistanceRef().store(std::max(distance, 0),
+                                        std::memory_order_relaxed);
+}
+
+// Requests the cache line of address for reading into all cache levels. The
+// hint is dropped by compilers without the builtin.
+inline void PrefetchRead(const void* address) {
+#if defined(__GNUC__) && !defined(GPU_ENABLED)
+  __builtin_prefetch(address, 0, 3);
+#endif
+}
@@ -0,0 +1,143 @@
+// MIT License
+
+// Copyright (c) 2023 Marc Hartung
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <omp.h>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+#include "vector.hpp"
+
+// Maps a value to the unsigned integral key it is ordered by. Specialize it for
+// types which are sorted by an integral key, e.g. key-index pairs.
+template <typename T, typename Enable = void>
+struct RadixKey {};
+
+template <typename T>
+struct RadixKey<
+    T, std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>>> {
+  using key_type = std::make_unsigned_t<T>;
+
+  static constexpr key_type Get(const T v) {
+    if constexpr (std::is_signed_v<T>) {
+      // flip the sign bit, so negative values are ordered first
+      return static_cast<key_type>(v) ^ (key_type(1) << (8 * sizeof(T) - 1));
+    } else {
+      return v;
+    }
+  }
+};
+
+template <typename T, typename Enable = void>
+struct IsRadixSortable : public std::false_type {};
+template <typename T>
+struct IsRadixSortable<T, std::void_t<typename RadixKey<T>::key_type>>
+    : public std::true_type {};
+
+namespace internal {
+inline constexpr int radix_digit_bits = 8;
+inline constexpr size_t radix_num_buckets = size_t(1) << radix_digit_bits;
+inline constexpr size_t radix_min_size = 1 << 12;
+}  // namespace internal
+
+// Stable parallel LSD radix sort. Every thread builds a histogram of its static
+// chunk per digit, an exclusive scan over (digit, thread) yields the scatter
+// offsets. Digits in which all keys are equal are skipped, so e.g. the unused
+// high bits of the morton codes of a small domain are never sorted. The values
+// are moved as a whole, key-index pairs need no indirection. The buffer comes
+// from the allocator of data, e.g. the StepArena for a ScratchVector.
+template <typename T, typename Allocator>
+void RadixSort(std::vector<T, Allocator>& data) {
+  using Key = typename RadixKey<T>::key_type;
+  using internal::radix_digit_bits, internal::radix_num_buckets;
+  constexpr Key digit_mask = radix_num_buckets - 1;
+  const auto key = [](const T& v) { return RadixKey<T>::Get(v); };
+  const size_t n = data.size();
+  if (n < internal::radix_min_size) {
+    std::stable_sort(data.begin(), data.end(),
+                     [key](const T& a, const T& b) { return key(a) < key(b); });
+    return;
+  }
+
+  Key key_or = 0, key_and = ~Key(0);
+#pragma omp parallel for schedule(static) reduction(| : key_or) \
+    reduction(& : key_and)
+  for (size_t i = 0; i < n; ++i) {
+    const Key k = key(data[i]);
+    key_or |= k;
+    key_and &= k;
+  }
+  const Key varying_bits = key_or ^ key_and;
+  std::vector<int> shifts;
+  for (int s = 0; s < static_cast<int>(8 * sizeof(Key));
+       s += radix_digit_bits) {
+    if ((varying_bits >> s) & digit_mask) {
+      shifts.push_back(s);
+    }
+  }
+  if (shifts.empty()) {
+    return;
+  }
+
+  std::vector<T, Allocator> buffer(n, data.get_allocator());
+  std::vector<std::array<size_t, radix_num_buckets>> offsets(
+      omp_get_max_threads());
+#pragma omp parallel num_threads(offsets.size())
+  {
+    T* src = data.data();
+    T* trg = buffer.data();
+    const size_t tid = omp_get_thread_num(), nt = omp_get_num_threads();
+    const size_t b = n * tid / nt, e = n * (tid + 1) / nt;
+    std::array<size_t, radix_num_buckets>& offset = offsets[tid];
+    for (const int shift : shifts) {
+      offset.fill(0);
+      for (size_t i = b; i < e; ++i) {
+        ++offset[(key(src[i]) >> shift) & digit_mask];
+      }
+#pragma omp barrier
+#pragma omp single
+      {
+        size_t sum = 0;
+        for (size_t d = 0; d < radix_num_buckets; ++d) {
+          for (size_t t = 0; t < nt; ++t) {
+            const size_t count = offsets[t][d];
+            offsets[t][d] = sum;
+            sum += count;
+          }
+        }
+      }
+      for (size_t i = b; i < e; ++i) {
+        trg[offset[(key(src[i]) >> shift) & digit_mask]++] = src[i];
+      }
+#pragma omp barrier
+      std::swap(src, trg);
+    }
+  }
+  if (shifts.size() % 2 == 1) {
+    std::swap(data, buffer);
+  }
+}
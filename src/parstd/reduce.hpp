@@ -22,20 +22,62 @@
 // OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 // SOFTWARE.
 
+#include <cstddef>
+#include <tuple>
+#include <utility>
+
 #include "execution.hpp"
 #include "vector.hpp"
 
 #ifndef GPU_ENABLED
+#include "internal/omp_algorithms.hpp"
+
+namespace internal {
+template <typename T, typename BinaryOp, typename IndexOp>
+T IndexTransformReduce(const size_t n, const T init, BinaryOp reduce_op,
+                       IndexOp transform_op) {
+  return omp::index_transform_reduce(n, init, reduce_op, transform_op);
+}
+}  // namespace internal
+
+#if defined(OMP_ENABLED) && !defined(TBB_ENABLED)
+namespace internal {
+using omp::reduce;
+using omp::transform_reduce;
+}
+#else
 #include <numeric>
 
 namespace internal {
 using std::reduce;
+using std::transform_reduce;
 }
+#endif
 #else
-#include <thrust/fill.h>
+#include <thrust/iterator/counting_iterator.h>
+#include <thrust/reduce.h>
+#include <thrust/transform_reduce.h>
 
 namespace internal {
 using thrust::reduce;
+
+template <typename T, typename BinaryOp, typename IndexOp>
+T IndexTransformReduce(const size_t n, const T init, BinaryOp reduce_op,
+                       IndexOp transform_op) {
+  return thrust::transform_reduce(std_exec_policy(),
+                                  thrust::counting_iterator<size_t>(0),
+                                  thrust::counting_iterator<size_t>(n),
+                                  transform_op, init, reduce_op);
+}
+
+// thrust expects the transform before init and reduce, unlike std
+template <typename ExecPolicy, typename It, typename T, typename BinaryOp,
+          typename UnaryOp>
+T transform_reduce(ExecPolicy&& policy, It first, It last, T init,
+                   BinaryOp reduce_op, UnaryOp transform_op) {
+  return thrust::transform_reduce(policy, first, last, transform_op, init,
+                                  reduce_op);
+}
 }
 #endif
 
@@ -52,4 +94,70 @@ T Reduce(const GpuVector<T>& v, const T init) {
 template <typename T, typename BinaryOp>
 T Reduce(const GpuVector<T>& v, const T init, BinaryOp op) {
   return internal::reduce(std_exec_policy(), v.begin(), v.end(), init, op);
-}
\ No newline at end of file
+}
+
+template <typename T, typename S, typename BinaryOp, typename UnaryOp>
+S TransformReduce(const GpuVector<T>& v, const S init, BinaryOp reduce_op,
+                  UnaryOp transform_op) {
+  return internal::transform_reduce(std_exec_policy(), v.begin(), v.end(), init,
+                                    reduce_op, transform_op);
+}
+
+struct MinOp {
+  template <typename T>
+  T operator()(const T& a, const T& b) const {
+    return (b < a) ? b : a;
+  }
+};
+
+struct MaxOp {
+  template <typename T>
+  T operator()(const T& a, const T& b) const {
+    return (a < b) ? b : a;
+  }
+};
+
+// Reduces transform_op(i) for all i in [0, n). Unlike the container version
+// it can combine several fields of the same index.
+template <typename T, typename BinaryOp, typename IndexOp>
+T TransformReduce(const size_t n, const T init, BinaryOp reduce_op,
+                  IndexOp transform_op) {
+  return internal::IndexTransformReduce(n, init, reduce_op, transform_op);
+}
+
+namespace internal {
+// applies the k-th operation to the k-th elements of two tuples
+template <typename... Ops>
+struct TupleOp {
+  template <typename Tuple>
+  Tuple operator()(const Tuple& a, const Tuple& b) const {
+    return Apply(a, b, std::index_sequence_for<Ops...>());
+  }
+
+  template <typename Tuple, size_t... K>
+  Tuple Apply(const Tuple& a, const Tuple& b, std::index_sequence<K...>) const {
+    return Tuple(std::get<K>(ops)(std::get<K>(a), std::get<K>(b))...);
+  }
+
+  std::tuple<Ops...> ops;
+};
+}  // namespace internal
+
+// Computes several reductions in a single pass, e.g. the maximum of one field
+// and the sum of another one. transform_op(i) returns a tuple, whose k-th
+// element is reduced with the k-th operation of ops.
+//   const auto [max_v, sum_m] = TransformReduce(
+//       n, std::tuple(0., 0.), std::tuple(MaxOp(), std::plus<>()),
+//       [&](size_t i) { return std::tuple(v[i], m[i]); });
+template <typename... Ts, typename... Ops, typename IndexOp>
+std::tuple<Ts...> TransformReduce(const size_t n, const std::tuple<Ts...> init,
+                                  const std::tuple<Ops...> ops,
+                                  IndexOp transform_op) {
+  static_assert(sizeof...(Ops) == sizeof...(Ts),
+                "TransformReduce: one operation per tuple element required");
+  return internal::IndexTransformReduce(
+      n, init, internal::TupleOp<Ops...>{ops},
+      [transform_op](const size_t i) {
+        return std::tuple<Ts...>(transform_op(i));
+      });
+}
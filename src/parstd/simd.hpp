@@ -0,0 +1,79 @@
+// MIT License
+
+// Copyright (c) 2023 Marc Hartung
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+
+// Instruction sets of the vectorized particle loops, ordered by width. The
+// loops of kScalar are the plain loops, the others are compiled for the
+// instruction set by TARGET_AVX2 and TARGET_AVX512 and chosen at runtime.
+enum class SimdIsa { kScalar, kAvx2, kAvx512 };
+
+#if defined(__x86_64__) && defined(__GNUC__) && !defined(GPU_ENABLED)
+#define SIMD_X86 1
+#define TARGET_AVX2 __attribute__((target("avx2,fma")))
+#if defined(__clang__)
+#define TARGET_AVX512 \
+  __attribute__((target("avx512f,avx512vl,avx512dq,avx2,fma")))
+#else
+// without the preference gcc keeps 32 byte vectors for avx512
+#define TARGET_AVX512                                           \
+  __attribute__((target("avx512f,avx512vl,avx512dq,avx2,fma," \
+                        "prefer-vector-width=512")))
+#endif
+#else
+#define TARGET_AVX2
+#define TARGET_AVX512
+#endif
+
+// The widest instruction set the cpu supports.
+inline SimdIsa DetectSimdIsa() {
+#ifdef SIMD_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vl") &&
+      __builtin_cpu_supports("avx512dq")) {
+    return SimdIsa::kAvx512;
+  }
+  if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+    return SimdIsa::kAvx2;
+  }
+#endif
+  return SimdIsa::kScalar;
+}
+
+namespace internal {
+inline std::atomic<SimdIsa>& SimdIsaRef() {
+  static std::atomic<SimdIsa> isa = DetectSimdIsa();
+  return isa;
+}
+}  // namespace internal
+
+inline SimdIsa GetSimdIsa() {
+  return internal::SimdIsaRef().load(std::memory_order_relaxed);
+}
+// capped to the instruction sets of the cpu
+inline void SetSimdIsa(const SimdIsa isa) {
+  internal::SimdIsaRef().store(std::min(isa, DetectSimdIsa()),
+                               std::memory_order_relaxed);
+}
@@ -26,11 +26,21 @@
 #include "vector.hpp"
 
 #ifndef GPU_ENABLED
+#include "radix_sort.hpp"
+
+#if defined(OMP_ENABLED) && !defined(TBB_ENABLED)
+#include "internal/omp_algorithms.hpp"
+
+namespace internal {
+using omp::sort;
+}
+#else
 #include <algorithm>
 
 namespace internal {
 using std::sort;
 }
+#endif
 #else
 #include <thrust/sort.h>
 
@@ -39,12 +49,20 @@ using thrust::sort;
 }
 #endif
 
-template <typename T>
-void Sort(GpuVector<T>& data) {
+// Types with an integral key (see RadixKey) are radix sorted on the CPU.
+// Vector is a GpuVector or a ScratchVector.
+template <typename Vector>
+void Sort(Vector& data) {
+#ifndef GPU_ENABLED
+  if constexpr (IsRadixSortable<typename Vector::value_type>::value) {
+    RadixSort(data);
+    return;
+  }
+#endif
   internal::sort(std_exec_policy(), data.begin(), data.end());
 }
 
-template <typename T, typename Comp>
-void Sort(GpuVector<T>& data, Comp comp) {
+template <typename Vector, typename Comp>
+void Sort(Vector& data, Comp comp) {
   internal::sort(std_exec_policy(), data.begin(), data.end(), comp);
 }
@@ -0,0 +1,157 @@
+// MIT License
+
+// Copyright (c) 2023 Marc Hartung
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "step_arena.hpp"
+
+#include <omp.h>
+
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+
+#include "numa_allocator.hpp"
+
+static uint64_t NextArenaId() {
+  static std::atomic<uint64_t> next_id = 1;
+  return next_id++;
+}
+
+StepArena::StepArena(const size_t chunk_bytes)
+    : chunk_bytes_(chunk_bytes), id_(NextArenaId()) {}
+
+StepArena::~StepArena() {
+  for (const auto& t : threads_) {
+    for (const Chunk c : t->chunks) {
+      FreeChunk(c);
+    }
+  }
+}
+
+StepArena::Chunk StepArena::NewChunk(const size_t bytes) {
+  // large chunks are mapped by the NumaAllocator, so a chunk created inside of
+  // a parallel region is placed on the node of its thread
+  return {NumaAllocator<std::byte>().allocate(bytes), bytes};
+}
+
+void StepArena::FreeChunk(const Chunk c) {
+  NumaAllocator<std::byte>().deallocate(c.data, c.size);
+}
+
+StepArena::ThreadChunks& StepArena::Local() {
+  // the id instead of the address identifies the arena, a new arena may be
+  // constructed at the address of a destroyed one
+  struct Cache {
+    uint64_t arena_id = 0;
+    ThreadChunks* chunks = nullptr;
+  };
+  thread_local Cache cache;
+  if (cache.arena_id != id_) {
+    const std::thread::id self = std::this_thread::get_id();
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto it =
+        std::find_if(threads_.begin(), threads_.end(),
+                     [self](const auto& t) { return t->owner == self; });
+    if (it != threads_.end()) {
+      cache = {id_, it->get()};
+    } else {
+      threads_.push_back(std::make_unique<ThreadChunks>());
+      threads_.back()->owner = self;
+      cache = {id_, threads_.back().get()};
+    }
+  }
+  return *cache.chunks;
+}
+
+void* StepArena::Allocate(const size_t bytes, const size_t align) {
+  ThreadChunks& t = Local();
+  const auto aligned_offset = [align](const Chunk c, const size_t offset) {
+    const uintptr_t p = reinterpret_cast<uintptr_t>(c.data) + offset;
+    return offset + (align - p % align) % align;
+  };
+  while (t.cur < t.chunks.size()) {
+    const Chunk c = t.chunks[t.cur];
+    const size_t begin = aligned_offset(c, t.offset);
+    if (begin + bytes <= c.size) {
+      t.used += begin + bytes - t.offset;
+      t.offset = begin + bytes;
+      return c.data + begin;
+    }
+    ++t.cur;
+    t.offset = 0;
+  }
+  t.chunks.push_back(
+      NewChunk(std::max({chunk_bytes_, bytes + align, t.merged_bytes})));
+  t.merged_bytes = 0;
+  t.cur = t.chunks.size() - 1;
+  const size_t begin = aligned_offset(t.chunks.back(), 0);
+  t.used += begin + bytes;
+  t.offset = begin + bytes;
+  return t.chunks.back().data + begin;
+}
+
+void StepArena::Reset() {
+  if (omp_in_parallel()) {
+    throw std::runtime_error("StepArena: Reset inside of a parallel region");
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  size_t in_use = 0;
+  for (const auto& t : threads_) {
+    in_use += t->used;
+    if (t->chunks.size() > 1) {
+      t->merged_bytes = 0;
+      for (const Chunk c : t->chunks) {
+        t->merged_bytes += c.size;
+        FreeChunk(c);
+      }
+      t->chunks.clear();
+    }
+    t->cur = 0;
+    t->offset = 0;
+    t->used = 0;
+  }
+  high_water_mark_ = std::max(high_water_mark_, in_use);
+}
+
+size_t StepArena::BytesInUse() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  size_t res = 0;
+  for (const auto& t : threads_) {
+    res += t->used;
+  }
+  return res;
+}
+
+size_t StepArena::ReservedBytes() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  size_t res = 0;
+  for (const auto& t : threads_) {
+    for (const Chunk c : t->chunks) {
+      res += c.size;
+    }
+  }
+  return res;
+}
+
+StepArena& GetStepArena() {
+  static StepArena arena;
+  return arena;
+}
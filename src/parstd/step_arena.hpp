@@ -0,0 +1,142 @@
+// MIT License
+
+// Copyright (c) 2023 Marc Hartung
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Bump allocator for the temporaries of a time step. Every thread allocates
+// from its own chunks, so no locking is needed after the first allocation of a
+// thread. Memory is never freed individually, Reset() at the end of a step
+// rewinds all chunks at once. Chunks which overflowed during a step are merged
+// into a single one, allocated by the next allocation of the same thread, so
+// after the first steps the arena serves every step from memory whose pages
+// are already mapped and placed on the node of the thread.
+//
+// Reset() must not be called while scratch memory is still in use or from
+// inside of a parallel region.
+class StepArena {
+ public:
+  static constexpr size_t default_chunk_bytes = size_t(4) << 20;
+
+  explicit StepArena(const size_t chunk_bytes = default_chunk_bytes);
+  ~StepArena();
+
+  StepArena(const StepArena&) = delete;
+  StepArena& operator=(const StepArena&) = delete;
+
+  void* Allocate(const size_t bytes, const size_t align);
+
+  void Reset();
+
+  // bytes handed out since the last Reset(), including alignment padding
+  size_t BytesInUse() const;
+  // maximum of BytesInUse() at the resets so far
+  size_t HighWaterMark() const { return high_water_mark_; }
+  // bytes held by the chunks of all threads
+  size_t ReservedBytes() const;
+
+ private:
+  struct Chunk {
+    std::byte* data = nullptr;
+    size_t size = 0;
+  };
+
+  struct alignas(64) ThreadChunks {
+    std::thread::id owner;
+    std::vector<Chunk> chunks;
+    size_t cur = 0;
+    size_t offset = 0;
+    size_t used = 0;
+    // size of the chunk which replaces the overflowed ones of the last step
+    size_t merged_bytes = 0;
+  };
+
+  ThreadChunks& Local();
+
+  static Chunk NewChunk(const size_t bytes);
+  static void FreeChunk(const Chunk c);
+
+  size_t chunk_bytes_;
+  uint64_t id_;
+  size_t high_water_mark_ = 0;
+
+  mutable std::mutex mutex_;
+  std::vector<std::unique_ptr<ThreadChunks>> threads_;
+};
+
+// The arena of the solver, reset by the time stepping after every step.
+StepArena& GetStepArena();
+
+// Allocator of the scratch vectors, deallocation is a no-op. Like the
+// NumaAllocator, elements constructed without arguments are
+// default-initialized.
+template <typename T>
+class ArenaAllocator {
+ public:
+  using value_type = T;
+
+  ArenaAllocator() : arena_(&GetStepArena()) {}
+  ArenaAllocator(StepArena& arena) : arena_(&arena) {}
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U>& a) : arena_(a.arena()) {}
+
+  T* allocate(const size_t n) {
+    return static_cast<T*>(arena_->Allocate(n * sizeof(T), alignof(T)));
+  }
+  void deallocate(T*, const size_t) {}
+
+  template <typename U>
+  void construct(U* p) noexcept(std::is_nothrow_default_constructible_v<U>) {
+    if constexpr (std::is_trivially_default_constructible_v<U>) {
+      ::new (static_cast<void*>(p)) U;
+    } else {
+      ::new (static_cast<void*>(p)) U();
+    }
+  }
+  template <typename U, typename... Args>
+  void construct(U* p, Args&&... args) {
+    ::new (static_cast<void*>(p)) U(std::forward<Args>(args)...);
+  }
+
+  StepArena* arena() const { return arena_; }
+
+  template <typename U>
+  bool operator==(const ArenaAllocator<U>& a) const {
+    return arena_ == a.arena();
+  }
+  template <typename U>
+  bool operator!=(const ArenaAllocator<U>& a) const {
+    return arena_ != a.arena();
+  }
+
+ private:
+  StepArena* arena_;
+};
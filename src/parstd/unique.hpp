@@ -26,26 +26,34 @@
 #include "vector.hpp"
 
 #ifndef GPU_ENABLED
+#if defined(OMP_ENABLED) && !defined(TBB_ENABLED)
+#include "internal/omp_algorithms.hpp"
+
+namespace internal {
+using omp::unique;
+}
+#else
 #include <algorithm>
 
 namespace internal {
 using std::unique;
 }
+#endif
 #else
 #include <thrust/unique.h>
 
 namespace internal {
-using thrust::sort;
+using thrust::unique;
 }
 #endif
-template <typename T>
-void Unique(GpuVector<T>& data) {
+template <typename Vector>
+void Unique(Vector& data) {
   auto it = internal::unique(std_exec_policy(), data.begin(), data.end());
   data.erase(it, data.end());
 }
 
-template <typename T, typename Comp>
-void Unique(GpuVector<T>& data, Comp comp) {
+template <typename Vector, typename Comp>
+void Unique(Vector& data, Comp comp) {
   auto it = internal::unique(std_exec_policy(), data.begin(), data.end(), comp);
   data.erase(it, data.end());
 }
@@ -24,6 +24,8 @@
 
 #pragma once
 
+#include "step_arena.hpp"
+
 #ifdef GPU_ENABLED
 
 #include <thrust/device_vector.h>
@@ -33,11 +35,38 @@ template <typename T>
 using GpuVector = thrust::device_vector<T>;
 template <typename T>
 using CpuVector = thrust::host_vector<T>;
+// temporaries of a step, the arena only serves host memory
+template <typename T>
+using ScratchVector = thrust::device_vector<T>;
 
 #else
 #include <vector>
 
+#include "numa_allocator.hpp"
+
+// A std::vector whose pages are placed by the NumaPolicy, see NumaAllocator.
+// Like thrust::device_vector, it can be created from a host std::vector.
+template <typename T>
+class GpuVector : public std::vector<T, NumaAllocator<T>> {
+  using Base = std::vector<T, NumaAllocator<T>>;
+
+ public:
+  using Base::Base;
+  GpuVector() = default;
+
+  template <typename Allocator>
+  GpuVector(const std::vector<T, Allocator>& v) : Base(v.begin(), v.end()) {}
+
+  template <typename Allocator>
+  GpuVector& operator=(const std::vector<T, Allocator>& v) {
+    this->assign(v.begin(), v.end());
+    return *this;
+  }
+};
+
+// Temporaries which die before the end of the time step, allocated from the
+// StepArena.
 template <typename T>
-using GpuVector = std::vector<T>;
+using ScratchVector = std::vector<T, ArenaAllocator<T>>;
 
 #endif
@@ -23,6 +23,7 @@
 #include <iostream>
 
 #include "io/write_domain.hpp"
+#include "parstd/execution_config.hpp"
 #include "preprocess/cases.hpp"
 #include "preprocess/mesh_shapes.hpp"
 #include "preprocess/solid_discretize.hpp"
@@ -30,6 +31,9 @@
 #include "wsph/time_stepping.hpp"
 
 int main() {
+  ApplyExecutionConfig(ExecutionConfig::FromEnvironment());
+  std::cout << ExecutionReport();
+
   CaseSetup setup = Cases::SimpleTank(100.);
   std::filesystem::create_directories(setup.output_dir);
   DualSPHysicsVerletTS ts(setup.gravity);
@@ -41,7 +41,7 @@ class Array {
     }
   }
 
-  Array() {}
+  Array() = default;
   DEVICE constexpr Array(const T &val) {
     ForeachI<0>([&](const size_t i) { elements[i] = val; });
   }
@@ -36,22 +36,9 @@ using Vectord = Array<double, 3>;
 using Vectori = Array<int32_t, 3>;
 using Vectoru = Array<uint32_t, 3>;
 
-#ifdef GPU_ENABLED
+#include "parstd/vector.hpp"
 
-#include <thrust/device_vector.h>
-#include <thrust/host_vector.h>
-
-template <typename T>
-using GpuVector = thrust::device_vector<T>;
-template <typename T>
-using CpuVector = thrust::host_vector<T>;
-
-#else
-#include <vector>
-
-template <typename T>
-using GpuVector = std::vector<T>;
+#ifndef GPU_ENABLED
 template <typename T>
 using CpuVector = std::vector<T>;
-
 #endif
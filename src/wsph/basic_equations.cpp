@@ -22,10 +22,11 @@
 
 #include "basic_equations.hpp"
 
-std::vector<double> ComputePressure(const std::vector<double>& density,
-                                    const double ref_density,
-                                    const double pressure_parameter) {
-  std::vector<double> pressure(density.size());
+GpuVector<double> ComputePressure(const GpuVector<double>& density,
+                                  const double ref_density,
+                                  const double pressure_parameter) {
+  GpuVector<double> pressure(density.size());
+#pragma omp parallel for schedule(static)
   for (size_t i = 0; i < pressure.size(); ++i) {
     pressure[i] = ComputePressure(density[i], ref_density, pressure_parameter);
   }
@@ -22,11 +22,14 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cmath>
+#include <memory>
 #include <vector>
 
 #include "utils/macros.hpp"
 #include "utils/math.hpp"
+#include "utils/types.hpp"
 
 DEVICE double ComputePressureParameter(const double ref_density,
                                        const double speed_of_sound) {
@@ -109,6 +112,258 @@ DEVICE constexpr double Chi(const double dist, const double dr) {
   return std::sqrt(Kernel(dist, dr) / Kernel(0.5 * dr, dr));
 }
 
-std::vector<double> ComputePressure(const std::vector<double>& density,
-                                    const double ref_density,
-                                    const double pressure_parameter);
+enum class KernelType { kWendland, kCubicSpline, kQuadraticSpline };
+
+// Kernel policies of the particle loops. The constructor computes the
+// constants of the smoothing length h once, W and Gradient evaluate the same
+// expressions as the kernel functions above with h fixed. WOfDist2 and
+// GradientOverDist, the gradient divided by the distance, take the squared
+// distance, which saves the square root for the TabulatedPolicy.
+class WendlandPolicy {
+ public:
+  DEVICE explicit WendlandPolicy(const double h)
+      : h1_(1. / h),
+        w_fac_(a * math::tpow<3>(h1_)),
+        gradient_fac_(-5. * a * math::tpow<4>(h1_)) {}
+
+  DEVICE double W(const double distance) const {
+    const double q = distance * h1_;
+    return w_fac_ * math::tpow<4>(1. - 0.5 * q) * (1. + 2. * q);
+  }
+  DEVICE double Gradient(const double distance) const {
+    const double q = distance * h1_;
+    return gradient_fac_ * q * math::tpow<3>(1. - 0.5 * q);
+  }
+  DEVICE double WOfDist2(const double dist2) const {
+    return W(std::sqrt(dist2));
+  }
+  DEVICE double GradientOverDist(const double dist2) const {
+    const double dist = std::sqrt(dist2);
+    return Gradient(dist) / dist;
+  }
+
+ private:
+  static constexpr double a = 21. / (16. * math::pi<double>());
+  double h1_;
+  double w_fac_;
+  double gradient_fac_;
+};
+
+class CubicSplinePolicy {
+ public:
+  DEVICE explicit CubicSplinePolicy(const double h)
+      : h1_(1. / h), fac_(1. / (math::pi<double>() * math::tpow<3>(h))) {}
+
+  DEVICE double W(const double distance) const {
+    const double q = distance * h1_;
+    if (q < 1.) {
+      return fac_ * (1. - 1.5 * math::tpow<2>(q) + 0.75 * math::tpow<3>(q));
+    } else {
+      return fac_ * 0.25 * math::tpow<3>(2. - q);
+    }
+  }
+  DEVICE double Gradient(const double distance) const {
+    const double q = distance * h1_;
+    if (q < 1.) {
+      return fac_ * (-3. * q + 2.25 * math::tpow<2>(q));
+    } else {
+      return fac_ * -0.75 * math::tpow<2>(2. - q);
+    }
+  }
+  DEVICE double WOfDist2(const double dist2) const {
+    return W(std::sqrt(dist2));
+  }
+  DEVICE double GradientOverDist(const double dist2) const {
+    const double dist = std::sqrt(dist2);
+    return Gradient(dist) / dist;
+  }
+
+ private:
+  double h1_;
+  double fac_;
+};
+
+class QuadraticSplinePolicy {
+ public:
+  DEVICE explicit QuadraticSplinePolicy(const double h)
+      : h1_(1. / h),
+        fac_((15. / (16. * math::pi<double>())) * math::tpow<3>(h1_)) {}
+
+  DEVICE double W(const double distance) const {
+    const double q = distance * h1_;
+    return fac_ * (0.25 * math::tpow<2>(q) - q + 1.);
+  }
+  DEVICE double Gradient(const double distance) const {
+    const double q = distance * h1_;
+    return fac_ * (0.5 * q - 1.);
+  }
+  DEVICE double WOfDist2(const double dist2) const {
+    return W(std::sqrt(dist2));
+  }
+  DEVICE double GradientOverDist(const double dist2) const {
+    const double dist = std::sqrt(dist2);
+    return Gradient(dist) / dist;
+  }
+
+ private:
+  double h1_;
+  double fac_;
+};
+
+// Chi of the kernel policy with the smoothing length dr, the kernel value at
+// half of dr is computed once.
+template <typename KernelPolicy>
+class ChiPolicy {
+ public:
+  DEVICE explicit ChiPolicy(const double dr)
+      : kernel_(dr), w_half_(kernel_.W(0.5 * dr)) {}
+
+  DEVICE double operator()(const double distance) const {
+    return std::sqrt(kernel_.W(distance) / w_half_);
+  }
+  DEVICE double OfDist2(const double dist2) const {
+    return (*this)(std::sqrt(dist2));
+  }
+
+ private:
+  KernelPolicy kernel_;
+  double w_half_;
+};
+
+namespace internal {
+// The tables sample q^2 in [0, kernel_table_q2_max] at kernel_table_intervals
+// equidistant points. They cover the neighbors of the verlet lists beyond the
+// support 2h, where the tables continue the analytic functions.
+inline constexpr size_t kernel_table_intervals = 2048;
+inline constexpr double kernel_table_q2_max = 9.;
+
+// f(dist2) of a table of kernel_table_intervals + 2 values at
+// dist2 = k / scale, interpolated by the Catmull-Rom spline through the four
+// values around dist2
+template <typename Sample, typename Get>
+DEVICE double InterpolateTable(const std::vector<Sample>& table,
+                               const double scale, const double dist2,
+                               Get&& get) {
+  const double x = dist2 * scale;
+  const size_t k = std::min(static_cast<size_t>(x), kernel_table_intervals - 1);
+  const double t = x - static_cast<double>(k);
+  const double p0 = get(table[k > 0 ? k - 1 : 0]), p1 = get(table[k]),
+               p2 = get(table[k + 1]), p3 = get(table[k + 2]);
+  return p1 + 0.5 * t *
+                  (p2 - p0 +
+                   t * (2. * p0 - 5. * p1 + 4. * p2 - p3 +
+                        t * (3. * (p1 - p2) + p3 - p0)));
+}
+}  // namespace internal
+
+// Kernel policy which looks up W and the gradient divided by the distance of
+// KernelPolicy in tables over q^2, so WOfDist2 and GradientOverDist need no
+// square root. The error relative to the maximum is below 1e-5 for q >= 0.3,
+// the gradient over the distance of the splines diverges for q -> 0. The
+// tables are shared by the copies of the policy.
+template <typename KernelPolicy>
+class TabulatedPolicy {
+ public:
+  explicit TabulatedPolicy(const double h)
+      : scale_(internal::kernel_table_intervals /
+               (internal::kernel_table_q2_max * h * h)) {
+    const KernelPolicy kernel(h);
+    auto table = std::make_shared<std::vector<Sample>>(
+        internal::kernel_table_intervals + 2);
+    for (size_t k = 0; k < table->size(); ++k) {
+      const double dist2 = k / scale_, dist = std::sqrt(dist2);
+      (*table)[k] = {kernel.W(dist), 0.};
+      if (k > 0) (*table)[k].gradient_over_dist = kernel.Gradient(dist) / dist;
+    }
+    // continued linearly, q -> 0 is never hit by a pair
+    (*table)[0].gradient_over_dist =
+        2. * (*table)[1].gradient_over_dist - (*table)[2].gradient_over_dist;
+    table_ = std::move(table);
+  }
+
+  DEVICE double W(const double distance) const {
+    return WOfDist2(distance * distance);
+  }
+  DEVICE double Gradient(const double distance) const {
+    return GradientOverDist(distance * distance) * distance;
+  }
+  DEVICE double WOfDist2(const double dist2) const {
+    return internal::InterpolateTable(*table_, scale_, dist2,
+                                      [](const Sample& s) { return s.w; });
+  }
+  DEVICE double GradientOverDist(const double dist2) const {
+    return internal::InterpolateTable(
+        *table_, scale_, dist2,
+        [](const Sample& s) { return s.gradient_over_dist; });
+  }
+
+ private:
+  struct Sample {
+    double w;
+    double gradient_over_dist;
+  };
+
+  double scale_;
+  std::shared_ptr<const std::vector<Sample>> table_;
+};
+
+// Chi of a tabulated kernel, Chi itself is tabulated over q^2 with the
+// smoothing length dr.
+template <typename KernelPolicy>
+class ChiPolicy<TabulatedPolicy<KernelPolicy>> {
+ public:
+  explicit ChiPolicy(const double dr)
+      : scale_(internal::kernel_table_intervals /
+               (internal::kernel_table_q2_max * dr * dr)) {
+    const ChiPolicy<KernelPolicy> chi(dr);
+    auto table =
+        std::make_shared<std::vector<double>>(internal::kernel_table_intervals +
+                                              2);
+    for (size_t k = 0; k < table->size(); ++k) {
+      (*table)[k] = chi.OfDist2(k / scale_);
+    }
+    table_ = std::move(table);
+  }
+
+  DEVICE double operator()(const double distance) const {
+    return OfDist2(distance * distance);
+  }
+  DEVICE double OfDist2(const double dist2) const {
+    return internal::InterpolateTable(*table_, scale_, dist2,
+                                      [](const double v) { return v; });
+  }
+
+ private:
+  double scale_;
+  std::shared_ptr<const std::vector<double>> table_;
+};
+
+// Calls f with the kernel policy of type for the smoothing length h. This is
+// the only branch on the kernel type, taken once before the particle loops.
+template <typename F>
+decltype(auto) DispatchKernel(const KernelType type, const double h, F&& f) {
+  switch (type) {
+    case KernelType::kWendland:
+      return f(WendlandPolicy(h));
+    case KernelType::kCubicSpline:
+      return f(CubicSplinePolicy(h));
+    default:
+      return f(QuadraticSplinePolicy(h));
+  }
+}
+
+// DispatchKernel with the TabulatedPolicy of the kernel if tabulated is set.
+template <typename F>
+decltype(auto) DispatchKernel(const KernelType type, const bool tabulated,
+                              const double h, F&& f) {
+  return DispatchKernel(type, h, [&](const auto& kernel) -> decltype(auto) {
+    if (tabulated) {
+      return f(TabulatedPolicy<std::decay_t<decltype(kernel)>>(h));
+    }
+    return f(kernel);
+  });
+}
+
+GpuVector<double> ComputePressure(const GpuVector<double>& density,
+                                  const double ref_density,
+                                  const double pressure_parameter);
@@ -22,6 +22,15 @@
 
 #include "derivatives.hpp"
 
+#include <omp.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "pair_loop.hpp"
+#include "parstd/simd.hpp"
+#include "simd_pairs.hpp"
+
 void Derivative::Step(const double dt, const Vectord gravity, Domain& d) {
 #pragma omp parallel for schedule(static)
   for (SizeT i = 0; i < d.p.size(); ++i) {
@@ -31,85 +40,213 @@ void Derivative::Step(const double dt, const Vectord gravity, Domain& d) {
     d.p.vel(i) += dt * (acc[i] + gravity);
     d.SetFluidPos(i, d.p.pos(i) + dt * d.p.vel(i));
   }
+  d.InvalidateCaches();
 }
 
-void BasicWeaklyRhs::Compute(const Domain& d, Derivative& res) {
-  ComputePP(true, d.p, d.p, d.p_p_neighbors, res);
-  if (d.pb.size() > 0) {
-    ComputePP(false, d.p, d.pb, d.p_pb_neighbors, res);
+namespace {
+struct PairSums {
+  Vectord acc = 0.;
+  double dtyD = 0.;
+  // density diffusion, only summed over fluid neighbors
+  double dtyDD = 0.;
+};
+
+// time step limits of the particles of one thread
+struct alignas(64) ThreadMaxima {
+  double courant = 0.;
+  double acc2 = 0.;
+};
+
+// Adds the contribution of neighbor j in nb to the sums of particle i, returns
+// the viscous Courant term of the pair. The reciprocals of the densities come
+// from the derived fields f of p and those of nb and the kernel gives the
+// gradient over the distance, so the only divisions left are the one of the
+// pair geometry and the one of the compressive viscosity. The pair geometry
+// is passed on to fused(rij, dist2, dist, vij_rij, wg).
+template <bool fluid_neighbor, typename Kernel, typename Fused>
+double AddPair(const Kernel& kernel, const Particles& p, const DerivedFields& f,
+               const PairFields& nb, const SizeT i, const SizeT j, PairSums& s,
+               Fused&& fused) {
+  const Vectord rij = p.pos(i) - nb.pos(j);
+  const double dist2 = rij * rij, dist = std::sqrt(dist2);
+  const double inv_dist2_eta2 = 1. / (dist2 + 0.01 * math::tpow<2>(p.h()));
+  // wg * rij / dist
+  const double g = kernel.GradientOverDist(dist2), wg = g * dist;
+  const Vectord grad = g * rij;
+  s.acc -= nb.mass() * (p.prs(i) + nb.prs(j)) *
+           (f.inv_dty(i) * nb.inv_dty(j)) * grad;
+
+  const Vectord vij = p.vel(i) - nb.vel(j);
+  const double vij_rij = vij * rij;
+  const double visc = p.h() * vij_rij * inv_dist2_eta2;
+  if (vij_rij < 0.) {
+    s.acc += nb.mass() * p.viscosity() * p.sos() * visc /
+             (0.5 * (p.dty(i) + nb.dty(j))) * grad;
+  }
+
+  s.dtyD += p.dty(i) * nb.vol(j) * (vij * grad);
+
+  if constexpr (fluid_neighbor) {
+    s.dtyDD += 2. * 0.1 * (nb.dty(j) - p.dty(i)) * inv_dist2_eta2 *
+               (wg * dist2) * nb.vol(j);
   }
+  fused(rij, dist2, dist, vij_rij, wg);
+  return std::abs(visc);
 }
+}  // namespace
 
-void BasicWeaklyRhs::ComputePP(const bool overwrite, const Particles& p,
-                               const Particles& np, const SavedNeighborsD& sn,
-                               Derivative& res) {
-  res.Resize(p.size());
-#pragma omp parallel for schedule(guided)
-  for (SizeT i = 0; i < p.size(); ++i) {
-    Vectord acc = 0.;
-    double dtyD = 0., dtyDD = 0.;
-    for (const SizeT j : sn.neighbors(i)) {
-      const Vectord rij = p.pos(i) - np.pos(j);
-      const double dist2 = rij * rij, dist = std::sqrt(dist2);
-      const double wg = KernelGradient(dist, p.h());
-      acc -= wg * np.mass() * (p.prs(i) + np.prs(j)) / (p.dty(i) * np.dty(j)) *
-             rij / dist;
-
-      const Vectord vij = p.vel(i) - np.vel(j);
-      if (vij * rij < 0.) {
-        acc += np.mass() * p.viscosity() * p.sos() *
-               (p.h() * vij * rij / (dist2 + 0.01 * math::tpow<2>(p.h()))) /
-               (0.5 * (p.dty(i) + np.dty(j))) * wg * rij / dist;
-      }
+void BasicWeaklyRhs::Compute(const Domain& d, Derivative& res) {
+  DispatchKernel(d.p.kernel(), d.p.tabulated_kernel(), d.p.h(),
+                 [&](const auto& kernel) {
+                   Compute<false>(kernel, d, res, nullptr);
+                 });
+}
 
-      dtyD += (p.dty(i) / np.dty(j)) * wg * np.mass() * vij * rij / dist;
+void BasicWeaklyRhs::Compute(const Domain& d, Derivative& res,
+                             DpcShifting& shifting) {
+  DispatchKernel(d.p.kernel(), d.p.tabulated_kernel(), d.p.h(),
+                 [&](const auto& kernel) {
+                   Compute<true>(kernel, d, res, &shifting);
+                 });
+}
 
-      dtyDD += 2. * 0.1 * (np.dty(j) - p.dty(i)) * rij /
-               (dist2 + 0.01 * math::tpow<2>(p.h())) * (wg * rij) *
-               (np.mass() / np.dty(j));
+template <bool with_shifting, typename Kernel>
+void BasicWeaklyRhs::Compute(const Kernel& kernel, const Domain& d,
+                             Derivative& res, DpcShifting* shifting) {
+  const Particles& p = d.p;
+  const bool with_boundary = d.pb.size() > 0;
+  res.Resize(p.size());
+  d.UpdateDerivedFields();
+  const DerivedFields& f = d.p_fields;
+  // the RHS is the first operator of a particle state, so it fills the caches
+  const bool fill_fluid = d.p_p_pairs.enabled();
+  const bool fill_boundary = with_boundary && d.p_pb_pairs.enabled();
+  if (fill_fluid) d.p_p_pairs.Prepare(d.p_p_neighbors);
+  if (fill_boundary) d.p_pb_pairs.Prepare(d.p_pb_neighbors);
+  if constexpr (with_shifting) shifting->Resize(p.size());
+  const ChiPolicy<Kernel> chi(p.dr());
+  // the vectorized loops fill the pair caches, but have no per pair hook for
+  // the shifting
+  const SimdIsa isa = GetSimdIsa();
+  const bool simd = !with_shifting && isa != SimdIsa::kScalar;
+  std::vector<ThreadMaxima> maxima(omp_get_max_threads());
+  // the fluid and boundary sums are added like the results of separate sweeps
+  const auto store_sums = [&](const SizeT i, const PairSums& fluid,
+                              const PairSums& boundary, const double courant) {
+    double dtyD = fluid.dtyD + p.h() * p.sos() * fluid.dtyDD;
+    Vectord acc = fluid.acc;
+    if (with_boundary) {
+      dtyD += boundary.dtyD;
+      acc += boundary.acc;
+    }
+    res.dtyD[i] = dtyD;
+    res.acc[i] = acc;
+    ThreadMaxima& m = maxima[omp_get_thread_num()];
+    m.courant = std::max(m.courant, courant);
+    m.acc2 = std::max(m.acc2, acc * acc);
+  };
+  const PairFields fluid_fields(p, &f), boundary_fields(d.pb, &d.pb_fields);
+  const auto particle_rhs = [&](const SizeT i, const NeighborList& fluid_list,
+                                const NeighborList& boundary_list) {
+    PairSums fluid, boundary;
+    DpcShifting::Terms fluid_shift, boundary_shift;
+    // the shifting terms and the cached geometry of pair k from the geometry
+    // of the RHS
+    const auto fused = [&](const PairFields& nb, const SizeT j,
+                           PairGeometry* pair, DpcShifting::Terms& t) {
+      return [&, j, pair](const Vectord& rij, const double dist2,
+                          const double dist, const double vij_rij,
+                          const double wg) {
+        if constexpr (with_shifting) {
+          shifting->AddPair(chi, p, f, nb, i, j, rij, dist2, vij_rij, t);
+        }
+        if (pair) {
+          const Vectord eij = rij / dist;
+          *pair = {Vectorf(eij[0], eij[1], eij[2]), static_cast<float>(dist),
+                   static_cast<float>(wg)};
+        }
+      };
+    };
+    double courant = 0.;
+    if (simd) {
+      const RhsSums fs = RhsPairsSimd(
+          isa, true, kernel, p, f, fluid_list.fields, i, fluid_list.neighbors,
+          fill_fluid ? d.p_p_pairs.pairs(i) : nullptr);
+      fluid = {fs.acc, fs.dtyD, fs.dtyDD};
+      courant = fs.courant;
+      if (with_boundary) {
+        const RhsSums bs = RhsPairsSimd(
+            isa, false, kernel, p, f, boundary_list.fields, i,
+            boundary_list.neighbors,
+            fill_boundary ? d.p_pb_pairs.pairs(i) : nullptr);
+        boundary = {bs.acc, bs.dtyD, bs.dtyDD};
+      }
+      store_sums(i, fluid, boundary, courant);
+      return;
+    }
+    PairGeometry* fluid_pairs = fill_fluid ? d.p_p_pairs.pairs(i) : nullptr;
+    fluid = SumPairs<PairSums>(
+        i, fluid_list.neighbors, fluid_list.fields,
+        [&](const PairFields& nb, const SizeT i, const SizeT j, const SizeT k,
+            PairSums& s) {
+          courant = std::max(
+              AddPair<true>(
+                  kernel, p, f, nb, i, j, s,
+                  fused(nb, j, fluid_pairs ? fluid_pairs + k : nullptr,
+                        fluid_shift)),
+              courant);
+        });
+    if (with_boundary) {
+      PairGeometry* boundary_pairs =
+          fill_boundary ? d.p_pb_pairs.pairs(i) : nullptr;
+      boundary = SumPairs<PairSums>(
+          i, boundary_list.neighbors, boundary_list.fields,
+          [&](const PairFields& nb, const SizeT i, const SizeT j,
+              const SizeT k, PairSums& s) {
+            AddPair<false>(
+                kernel, p, f, nb, i, j, s,
+                fused(nb, j, boundary_pairs ? boundary_pairs + k : nullptr,
+                      boundary_shift));
+          });
     }
-    if (overwrite) {
-      res.dtyD[i] = dtyD + p.h() * p.sos() * dtyDD;
-      res.acc[i] = acc;
-    } else {
-      res.dtyD[i] += dtyD;
-      res.acc[i] += acc;
+    if constexpr (with_shifting) {
+      shifting->Set(i, fluid_shift, with_boundary ? &boundary_shift : nullptr);
     }
+    store_sums(i, fluid, boundary, courant);
+  };
+  if (with_boundary) {
+    ForEachParticleNeighbors(p.size(), d.p_p_neighbors, fluid_fields,
+                             d.p_pb_neighbors, boundary_fields, particle_rhs);
+  } else {
+    ForEachParticleNeighbors(
+        p.size(), d.p_p_neighbors, fluid_fields,
+        [&](const SizeT i, const NeighborList& fluid_list) {
+          particle_rhs(i, fluid_list,
+                       {boundary_fields, SavedNeighborsD::ConstRange()});
+        });
+  }
+  if (fill_fluid) d.p_p_pairs.SetValid();
+  if (fill_boundary) d.p_pb_pairs.SetValid();
+  max_courant_ = 0.;
+  max_acc2_ = 0.;
+  for (const ThreadMaxima& m : maxima) {
+    max_courant_ = std::max(max_courant_, m.courant);
+    max_acc2_ = std::max(max_acc2_, m.acc2);
   }
 }
 
-double BasicWeaklyRhs::ComputeMaxDt(const Domain& d,
-                                    const Derivative& derivative) {
-  return std::min(CourantViscDt(d.p, d.p_p_neighbors),
-                  ForceDt(d.p.h(), derivative));
+double BasicWeaklyRhs::ComputeMaxDt(const Domain& d, const Derivative&) {
+  return std::min(CourantViscDt(d.p), ForceDt(d.p.h()));
 }
 
-double BasicWeaklyRhs::CourantViscDt(const Particles& p,
-                                     const SavedNeighborsD& neighbors) {
-  double courant = 0.;
-#pragma omp parallel for schedule(dynamic, 27) reduction(max : courant)
-  for (SizeT i = 0; i < p.size(); ++i) {
-    double tmp_c = 0.;
-    for (const SizeT j : neighbors.neighbors(i)) {
-      const Vectord rij = p.pos(i) - p.pos(j);
-      const double dist2 = rij * rij;
-      const double vij_rij = (p.vel(i) - p.vel(j)) * rij;
-      const double tmp =
-          std::abs(p.h() * vij_rij / (dist2 + 0.01 * math::tpow<2>(p.h())));
-      tmp_c = std::max(tmp, tmp_c);
-    }
-    courant = std::max(courant, tmp_c);
-  }
-  const double dt = cfl() * p.h() / (p.sos() + courant);
+double BasicWeaklyRhs::CourantViscDt(const Particles& p) const {
+  const double dt = cfl() * p.h() / (p.sos() + max_courant_);
   return dt;
 }
 
-double BasicWeaklyRhs::ForceDt(const double h, const Derivative& d) {
-  double max_acc_mag = 0.;
-#pragma omp parallel for schedule(guided) reduction(max : max_acc_mag)
-  for (SizeT i = 0; i < d.size(); ++i) {
-    max_acc_mag = std::max(max_acc_mag, Length(d.acc[i]));
-  }
+double BasicWeaklyRhs::ForceDt(const double h) const {
+  // the square root is taken once for the maximum instead of per particle
+  const double max_acc_mag = std::sqrt(max_acc2_);
   const double dt = cfl() * std::sqrt(h) / max_acc_mag;
   return dt;
-}
\ No newline at end of file
+}
@@ -26,6 +26,7 @@
 
 #include "domain.hpp"
 #include "particles.hpp"
+#include "shifting.hpp"
 #include "utils/types.hpp"
 
 struct Derivative {
@@ -38,8 +39,8 @@ struct Derivative {
 
   void Step(const double dt, const Vectord gravity, Domain& d);
 
-  std::vector<Vectord> acc;
-  std::vector<double> dtyD;
+  GpuVector<Vectord> acc;
+  GpuVector<double> dtyD;
 };
 
 class BasicWeaklyRhs {
@@ -49,16 +50,28 @@ class BasicWeaklyRhs {
 
   double cfl() const { return cfl_; }
 
+  // Walks the fluid and the boundary neighbors of every particle in a single
+  // sweep, which also reduces the maxima of the time step limits.
   void Compute(const Domain& d, Derivative& res);
+  // Compute with the DpcShifting terms of the same state, from the pair
+  // geometry of the RHS instead of a second traversal of the neighbors.
+  void Compute(const Domain& d, Derivative& res, DpcShifting& shifting);
+  // The time step limit of the derivative of the last Compute, from the
+  // maxima reduced by its sweep.
   double ComputeMaxDt(const Domain& d, const Derivative& derivative);
 
  private:
-  void ComputePP(const bool overwrite, const Particles& p, const Particles& np,
-                 const SavedNeighborsD& sn, Derivative& res);
+  template <bool with_shifting, typename Kernel>
+  void Compute(const Kernel& kernel, const Domain& d, Derivative& res,
+               DpcShifting* shifting);
 
-  double CourantViscDt(const Particles& p, const SavedNeighborsD& neighbors);
+  double CourantViscDt(const Particles& p) const;
 
-  double ForceDt(const double h, const Derivative& d);
+  double ForceDt(const double h) const;
 
   double cfl_ = 1.1;
+  // maximum of the viscous Courant term over the fluid neighbors
+  double max_courant_ = 0.;
+  // maximum of |acc|^2
+  double max_acc2_ = 0.;
 };
\ No newline at end of file
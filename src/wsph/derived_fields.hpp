@@ -0,0 +1,105 @@
+// MIT License
+
+// Copyright (c) 2023 Marc Hartung
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <atomic>
+
+#include "particles.hpp"
+#include "utils/types.hpp"
+
+// The fields of a neighbor which every pair reads, packed into one cache line,
+// so a neighbor costs one line instead of one per array.
+struct alignas(64) PairRecord {
+  Vectord pos;
+  Vectord vel;
+  double dty;
+  double prs;
+};
+static_assert(sizeof(PairRecord) == 64);
+
+namespace internal {
+inline std::atomic<bool>& PairRecordsRef() {
+  static std::atomic<bool> enabled = false;
+  return enabled;
+}
+}  // namespace internal
+
+// Whether the derived fields stage packs the PairRecords the pair loops
+// gather the neighbors from, instead of reading the separate arrays.
+inline bool GetPairRecords() {
+  return internal::PairRecordsRef().load(std::memory_order_relaxed);
+}
+inline void SetPairRecords(const bool enabled) {
+  internal::PairRecordsRef().store(enabled, std::memory_order_relaxed);
+}
+
+// Per-particle terms of the pair loops which only depend on one particle,
+// computed once per particle state so the pair loops multiply instead of
+// divide. The fields are stored as separate arrays in the particle order, with
+// GetPairRecords also the packed PairRecords.
+class DerivedFields {
+ public:
+  DerivedFields() = default;
+
+  void Update(const Particles& p) {
+    inv_dty_.resize(p.size());
+    vol_.resize(p.size());
+    const double mass = p.mass();
+#pragma omp parallel for schedule(static)
+    for (SizeT i = 0; i < p.size(); ++i) {
+      const double inv_dty = 1. / p.dty(i);
+      inv_dty_[i] = inv_dty;
+      vol_[i] = mass * inv_dty;
+    }
+    if (GetPairRecords()) {
+      records_.resize(p.size());
+#pragma omp parallel for schedule(static)
+      for (SizeT i = 0; i < p.size(); ++i) {
+        records_[i] = {p.pos(i), p.vel(i), p.dty(i), p.prs(i)};
+      }
+    } else {
+      records_.clear();
+    }
+    valid_ = true;
+  }
+
+  bool valid() const { return valid_; }
+  void Invalidate() { valid_ = false; }
+
+  SizeT size() const { return inv_dty_.size(); }
+
+  // 1 / density
+  const GpuVector<double>& inv_dty() const { return inv_dty_; }
+  double inv_dty(const SizeT i) const { return inv_dty_[i]; }
+  // volume mass / density
+  const GpuVector<double>& vol() const { return vol_; }
+  double vol(const SizeT i) const { return vol_[i]; }
+  // the packed hot fields, empty without GetPairRecords
+  const GpuVector<PairRecord>& records() const { return records_; }
+
+ private:
+  bool valid_ = false;
+  GpuVector<double> inv_dty_;
+  GpuVector<double> vol_;
+  GpuVector<PairRecord> records_;
+};
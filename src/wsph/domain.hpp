@@ -22,7 +22,9 @@
 
 #pragma once
 
+#include "derived_fields.hpp"
 #include "mesh.hpp"
+#include "neighbor/pair_cache.hpp"
 #include "neighbor/position_tracker.hpp"
 #include "neighbor/saved_neighbors.hpp"
 #include "neighbor/verlet_neighbors.hpp"
@@ -45,11 +47,35 @@ struct Domain {
 
   void Update() {
     p.Update();
-    p_p_neighbors = SavedNeighborsD(p.pos());
+    // updating in place keeps the memory of the neighbor lists
+    p_p_neighbors.Update(p.pos());
     if (pb.size() > 0) {
-      p_pb_neighbors = SavedNeighborsD(p.pos(), pb.pos());
+      p_pb_neighbors.Update(p.pos(), pb.pos());
     }
     fluid_pos_tracker.Reset(p.size());
+    InvalidateCaches();
+  }
+
+  // num_reuses operators read the pair geometry of a particle state after
+  // the RHS filled it, e.g. a shifting of the same state
+  void PlanPairCache(const size_t num_reuses) {
+    p_p_pairs.Plan(num_reuses);
+    p_pb_pairs.Plan(num_reuses);
+  }
+  // called by everything which moves the fluid particles or changes their
+  // densities
+  void InvalidateCaches() {
+    p_p_pairs.Invalidate();
+    p_pb_pairs.Invalidate();
+    p_fields.Invalidate();
+    pb_fields.Invalidate();
+  }
+
+  // The derived fields stage of a particle state, run by its first operator
+  // after the boundary is interpolated.
+  void UpdateDerivedFields() const {
+    p_fields.Update(p);
+    if (pb.size() > 0) pb_fields.Update(pb);
   }
 
   double verlet_factor = 1.2;
@@ -57,8 +83,13 @@ struct Domain {
   Particles p;
   PositionTracker fluid_pos_tracker;
   SavedNeighborsD p_p_neighbors;
+  // caches of the operators, filled and read through a const Domain
+  mutable PairCache p_p_pairs;
+  mutable DerivedFields p_fields;
 
   Mesh m;
   ParticleBoundary pb;
   SavedNeighborsD p_pb_neighbors;
+  mutable PairCache p_pb_pairs;
+  mutable DerivedFields pb_fields;
 };
\ No newline at end of file
@@ -22,6 +22,7 @@
 
 #pragma once
 
+#include "basic_equations.hpp"
 #include "utils/types.hpp"
 
 struct MaterialSettings {
@@ -29,6 +30,9 @@ struct MaterialSettings {
   double speed_of_sound = 10.;
   double smoothing_ratio = 1.5;
   double dr = 0.1;
+  KernelType kernel = KernelType::kQuadraticSpline;
+  // looks the kernel up in tables over q^2, see TabulatedPolicy
+  bool tabulated_kernel = false;
 
   static MaterialSettings Water() { return MaterialSettings(); }
 };
\ No newline at end of file
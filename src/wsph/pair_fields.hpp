@@ -0,0 +1,146 @@
+// MIT License
+
+// Copyright (c) 2023 Marc Hartung
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <array>
+
+#include "container/soa_vector.hpp"
+#include "derived_fields.hpp"
+#include "parstd/prefetch.hpp"
+#include "particles.hpp"
+#include "utils/types.hpp"
+
+// The fields of the neighbors which the pair loops read, indexed by the
+// neighbor index. They point either into a Particles object and its
+// DerivedFields, into its packed PairRecords or into the buffers of a
+// PairStage. The hot fields pos, vel, dty and prs are read with strides, so
+// the loops read the separate arrays and the records the same way. The
+// velocity components have their own pointers, which also covers the
+// structure of arrays VelocityVector.
+class PairFields {
+ public:
+  PairFields() = default;
+
+  // The derived fields may be left out by loops which do not read them, e.g.
+  // the interpolation of the boundary. The hot fields are read from the
+  // PairRecords of nf if it has them.
+  explicit PairFields(const Particles& np, const DerivedFields* nf = nullptr)
+      : PairFields(np.pos().points().data(), nullptr, np.dty().data(),
+                   np.prs().data(), nf ? nf->inv_dty().data() : nullptr,
+                   nf ? nf->vol().data() : nullptr, np.mass()) {
+    SetVel(np.vel());
+    if (nf && !nf->records().empty()) {
+      const PairRecord* records = nf->records().data();
+      pos_ = records->pos.data();
+      for (int c = 0; c < 3; ++c) {
+        vel_[c] = &records->vel[c];
+      }
+      dty_ = &records->dty;
+      prs_ = &records->prs;
+      vec_stride_ = vel_stride_ = scalar_stride_ = record_stride;
+    }
+  }
+
+  PairFields(const Vectord* pos, const Vectord* vel, const double* dty,
+             const double* prs, const double* inv_dty, const double* vol,
+             const double mass)
+      : pos_(reinterpret_cast<const double*>(pos)),
+        dty_(dty),
+        prs_(prs),
+        inv_dty_(inv_dty),
+        vol_(vol),
+        mass_(mass) {
+    if (vel) SetVel(vel);
+  }
+
+  const Vectord& pos(const SizeT j) const {
+    return *reinterpret_cast<const Vectord*>(pos_ + vec_stride_ * j);
+  }
+  Vectord vel(const SizeT j) const {
+    const SizeT k = vel_stride_ * j;
+    return Vectord(vel_[0][k], vel_[1][k], vel_[2][k]);
+  }
+  double dty(const SizeT j) const { return dty_[scalar_stride_ * j]; }
+  double prs(const SizeT j) const { return prs_[scalar_stride_ * j]; }
+  double inv_dty(const SizeT j) const { return inv_dty_[j]; }
+  double vol(const SizeT j) const { return vol_[j]; }
+  double mass() const { return mass_; }
+
+  // The arrays, for the vectorized loops. The position of neighbor j starts
+  // at vec_stride() * j, the component c of its velocity is at
+  // vel_component(c)[vel_stride() * j], its dty and prs at
+  // scalar_stride() * j.
+  const double* pos() const { return pos_; }
+  const double* vel_component(const int c) const { return vel_[c]; }
+  const double* dty() const { return dty_; }
+  const double* prs() const { return prs_; }
+  const double* inv_dty() const { return inv_dty_; }
+  const double* vol() const { return vol_; }
+  SizeT vec_stride() const { return vec_stride_; }
+  SizeT vel_stride() const { return vel_stride_; }
+  SizeT scalar_stride() const { return scalar_stride_; }
+  bool has_derived() const { return inv_dty_ != nullptr; }
+  bool packed() const { return vec_stride_ == record_stride; }
+
+  // requests the fields of neighbor j
+  void Prefetch(const SizeT j) const {
+    PrefetchRead(pos_ + vec_stride_ * j);
+    if (packed()) return;
+    PrefetchRead(vel_[0] + vel_stride_ * j);
+    if (vel_stride_ == 1) {
+      PrefetchRead(vel_[1] + j);
+      PrefetchRead(vel_[2] + j);
+    }
+    PrefetchRead(dty_ + j);
+    PrefetchRead(prs_ + j);
+  }
+
+  // the stride of the PairRecords in doubles
+  static constexpr SizeT record_stride = sizeof(PairRecord) / sizeof(double);
+
+ private:
+  void SetVel(const Vectord* vel) {
+    for (int c = 0; c < 3; ++c) {
+      vel_[c] = reinterpret_cast<const double*>(vel) + c;
+    }
+    vel_stride_ = 3;
+  }
+  void SetVel(const GpuVector<Vectord>& vel) { SetVel(vel.data()); }
+  void SetVel(const SoaVector<double, 3>& vel) {
+    for (int c = 0; c < 3; ++c) {
+      vel_[c] = vel.data(c);
+    }
+    vel_stride_ = 1;
+  }
+
+  const double* pos_ = nullptr;
+  std::array<const double*, 3> vel_ = {nullptr, nullptr, nullptr};
+  const double* dty_ = nullptr;
+  const double* prs_ = nullptr;
+  const double* inv_dty_ = nullptr;
+  const double* vol_ = nullptr;
+  SizeT vec_stride_ = 3;
+  SizeT vel_stride_ = 3;
+  SizeT scalar_stride_ = 1;
+  double mass_ = 0.;
+};
@@ -0,0 +1,191 @@
+// MIT License
+
+// Copyright (c) 2023 Marc Hartung
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <type_traits>
+
+#include "neighbor/saved_neighbors.hpp"
+#include "pair_fields.hpp"
+#include "pair_stage.hpp"
+#include "parstd/parallel_for.hpp"
+#include "parstd/prefetch.hpp"
+#include "parstd/ranges.hpp"
+#include "parstd/simd.hpp"
+#include "utils/macros.hpp"
+#include "utils/types.hpp"
+
+// The traversal of the particle operators of wsph. An operator supplies what
+// it sums per pair and what it does with the sums of a particle, the loops
+// here decide in which order, on which threads, with which instruction set and
+// from which copy of the neighbor fields the pairs are visited. The neighbor
+// lists are full lists, every particle sums over all of its neighbors and only
+// writes its own results.
+
+// the number of neighbors drops sharply at free surfaces and in splashes
+inline constexpr size_t pair_loop_grain = 32;
+
+// Calls particle(i) for all particles i < n in parallel, balanced by
+// ParallelFor with the global schedule.
+template <typename Particle>
+void ForEachParticle(const SizeT n, Particle&& particle) {
+  ParallelFor(IndexRange<SizeT>(n), pair_loop_grain, particle);
+}
+
+// The sums of pair(fields, i, j, k, sums) over the neighbors j = neighbors[k]
+// of particle i, whose fields are read from fields, starting from a default
+// constructed Sums. With a GetPrefetchDistance d > 0, fields.Prefetch(
+// neighbors[k + d]) is called before pair k.
+template <typename Sums, typename Fields, typename Pair>
+DEVICE Sums SumPairs(const SizeT i, const SavedNeighborsD::ConstRange neighbors,
+                     const Fields& fields, Pair&& pair) {
+  Sums sums;
+  const SizeT n = neighbors.size();
+  const SizeT d = GetPrefetchDistance();
+  SizeT k = 0;
+  if (d > 0) {
+    for (; k + d < n; ++k) {
+      fields.Prefetch(neighbors[k + d]);
+      pair(fields, i, neighbors[k], k, sums);
+    }
+  }
+  for (; k < n; ++k) {
+    pair(fields, i, neighbors[k], k, sums);
+  }
+  return sums;
+}
+
+// The neighbors of one particle and the fields to read them from, the
+// staged copies of a PairStage in tiled loops.
+struct NeighborList {
+  const PairFields& fields;
+  SavedNeighborsD::ConstRange neighbors;
+};
+
+namespace internal {
+template <bool two_lists, typename Particle>
+void ForEachNeighborLists(const SizeT n, const SavedNeighborsD& sn,
+                          const PairFields& fields, const SavedNeighborsD* sn2,
+                          const PairFields& fields2, Particle& particle) {
+  const auto visit = [&](const SizeT i, const NeighborList& list,
+                         const NeighborList& list2) {
+    if constexpr (two_lists) {
+      particle(i, list, list2);
+    } else {
+      particle(i, list);
+    }
+  };
+  const auto neighbors2 = [&](const SizeT i) {
+    return two_lists ? sn2->neighbors(i)
+                     : SavedNeighborsD::ConstRange(nullptr, nullptr);
+  };
+  const SizeT tile = PairTileSize(fields.has_derived());
+  if (tile == 0) {
+    ForEachParticle(n, [&](const SizeT i) {
+      visit(i, {fields, sn.neighbors(i)}, {fields2, neighbors2(i)});
+    });
+    return;
+  }
+  ParallelFor(IndexRange<SizeT>((n + tile - 1) / tile), 1,
+              [&](const SizeT t) {
+                const SizeT b = t * tile, e = std::min(n, b + tile);
+                PairStage& stage = ThreadPairStage(0);
+                PairStage& stage2 = ThreadPairStage(1);
+                const bool staged = stage.Stage(sn, fields, b, e);
+                const bool staged2 =
+                    two_lists && stage2.Stage(*sn2, fields2, b, e);
+                for (SizeT i = b; i < e; ++i) {
+                  visit(i,
+                        staged ? NeighborList{stage.fields(),
+                                              stage.neighbors(i)}
+                               : NeighborList{fields, sn.neighbors(i)},
+                        staged2 ? NeighborList{stage2.fields(),
+                                               stage2.neighbors(i)}
+                                : NeighborList{fields2, neighbors2(i)});
+                }
+              });
+}
+}  // namespace internal
+
+// Calls particle(i, list) for all particles i < n with the NeighborList of
+// the neighbors sn.neighbors(i) in fields. With a PairTileSize > 0 the
+// particles are processed in tiles whose neighbor fields are staged by the
+// PairStages of the thread, otherwise one by one by ForEachParticle.
+template <typename Particle>
+void ForEachParticleNeighbors(const SizeT n, const SavedNeighborsD& sn,
+                              const PairFields& fields, Particle&& particle) {
+  internal::ForEachNeighborLists<false>(n, sn, fields, nullptr, fields,
+                                        particle);
+}
+// the same with a second list, particle(i, list, list2), e.g. the fluid and
+// the boundary neighbors of the fused RHS sweep
+template <typename Particle>
+void ForEachParticleNeighbors(const SizeT n, const SavedNeighborsD& sn,
+                              const PairFields& fields,
+                              const SavedNeighborsD& sn2,
+                              const PairFields& fields2, Particle&& particle) {
+  internal::ForEachNeighborLists<true>(n, sn, fields, &sn2, fields2,
+                                       particle);
+}
+
+// marks an operator without a vectorized neighbor loop
+struct NoSimdPairs {};
+
+// Calls finalize(i, sums) for all particles i < n with the SumPairs of pair
+// over the neighbors sn.neighbors(i) in fields, traversed by
+// ForEachParticleNeighbors. If simd_pairs is given and GetSimdIsa() is not
+// kScalar, sums = simd_pairs(isa, fields, i, neighbors) replaces the scalar
+// loop, e.g. one of the loops of simd_pairs.hpp.
+template <typename Sums, typename Pair, typename Finalize,
+          typename SimdPairs = NoSimdPairs>
+void ForEachPair(const SizeT n, const SavedNeighborsD& sn,
+                 const PairFields& fields, Pair&& pair, Finalize&& finalize,
+                 SimdPairs&& simd_pairs = {}) {
+  constexpr bool has_simd =
+      !std::is_same_v<std::decay_t<SimdPairs>, NoSimdPairs>;
+  const SimdIsa isa = GetSimdIsa();
+  const bool simd = has_simd && isa != SimdIsa::kScalar;
+  ForEachParticleNeighbors(
+      n, sn, fields, [&](const SizeT i, const NeighborList& list) {
+        if constexpr (has_simd) {
+          if (simd) {
+            finalize(i, static_cast<Sums>(simd_pairs(isa, list.fields, i,
+                                                     list.neighbors)));
+            return;
+          }
+        }
+        finalize(i, SumPairs<Sums>(i, list.neighbors, list.fields, pair));
+      });
+}
+
+// res = value for the first neighbor list of an operator, res += value for
+// the following ones, e.g. the boundary neighbors after the fluid neighbors
+template <typename T>
+DEVICE void StoreOrAdd(const bool overwrite, T& res, const T& value) {
+  if (overwrite) {
+    res = value;
+  } else {
+    res += value;
+  }
+}
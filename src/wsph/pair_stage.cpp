@@ -0,0 +1,110 @@
+// MIT License
+
+// Copyright (c) 2023 Marc Hartung
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "pair_stage.hpp"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <limits>
+
+size_t DetectL2CacheBytes() {
+#ifdef _SC_LEVEL2_CACHE_SIZE
+  const long bytes = sysconf(_SC_LEVEL2_CACHE_SIZE);
+  if (bytes > 0) return bytes;
+#endif
+  return size_t(1) << 20;
+}
+
+SizeT PairTileSize(const bool with_derived) {
+  const size_t bytes = GetPairTileBytes();
+  if (bytes == 0) return 0;
+  const size_t staged_bytes = 2 * sizeof(Vectord) + 2 * sizeof(double) +
+                              (with_derived ? 2 * sizeof(double) : 0);
+  return std::max<size_t>(
+      bytes / (staged_bytes * internal::pair_stage_halo_factor), 1);
+}
+
+bool PairStage::Stage(const SavedNeighborsD& sn, const PairFields& fields,
+                      const SizeT b, const SizeT e) {
+  constexpr SizeT none = std::numeric_limits<SizeT>::max();
+  SizeT first = none, last = 0;
+  for (SizeT i = b; i < e; ++i) {
+    for (const SizeT j : sn.neighbors(i)) {
+      first = std::min(first, j);
+      last = std::max(last, j);
+    }
+  }
+  begin_ = b;
+  offsets_.assign(1, 0);
+  neighbors_.clear();
+  if (first == none) {
+    offsets_.resize(e - b + 1, 0);
+    pos_.clear();
+    fields_ = PairFields();
+    return true;
+  }
+  if (last - first >= internal::pair_stage_max_window) return false;
+
+  // marks the neighbors of the tile, then numbers them in index order
+  local_.assign(last - first + 1, none);
+  for (SizeT i = b; i < e; ++i) {
+    for (const SizeT j : sn.neighbors(i)) {
+      local_[j - first] = 0;
+    }
+  }
+  const bool derived = fields.has_derived();
+  pos_.clear();
+  vel_.clear();
+  dty_.clear();
+  prs_.clear();
+  inv_dty_.clear();
+  vol_.clear();
+  for (SizeT w = 0; w < local_.size(); ++w) {
+    if (local_[w] == none) continue;
+    const SizeT j = first + w;
+    local_[w] = pos_.size();
+    pos_.push_back(fields.pos(j));
+    vel_.push_back(fields.vel(j));
+    dty_.push_back(fields.dty(j));
+    prs_.push_back(fields.prs(j));
+    if (derived) {
+      inv_dty_.push_back(fields.inv_dty(j));
+      vol_.push_back(fields.vol(j));
+    }
+  }
+  for (SizeT i = b; i < e; ++i) {
+    for (const SizeT j : sn.neighbors(i)) {
+      neighbors_.push_back(local_[j - first]);
+    }
+    offsets_.push_back(neighbors_.size());
+  }
+  fields_ = PairFields(pos_.data(), vel_.data(), dty_.data(), prs_.data(),
+                       derived ? inv_dty_.data() : nullptr,
+                       derived ? vol_.data() : nullptr, fields.mass());
+  return true;
+}
+
+PairStage& ThreadPairStage(const int list) {
+  static thread_local PairStage stages[2];
+  return stages[list];
+}
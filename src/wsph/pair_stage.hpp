@@ -0,0 +1,100 @@
+// MIT License
+
+// Copyright (c) 2023 Marc Hartung
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+#include "neighbor/saved_neighbors.hpp"
+#include "pair_fields.hpp"
+#include "utils/types.hpp"
+
+// Cell tiled pair loops. The particles are sorted along the cells, so a range
+// of consecutive particles is a compact tile of cells. Its neighbors, the tile
+// and its halo, are copied into contiguous buffers sized to the L2 cache
+// before the pairs of the tile are computed from there, instead of gathering
+// them from the whole domain for every particle.
+
+namespace internal {
+inline std::atomic<size_t>& PairTileBytesRef() {
+  static std::atomic<size_t> bytes = 0;
+  return bytes;
+}
+// Staged neighbors per particle of a tile. A tile of a few hundred particles
+// along the cell order touches about this many times as many neighbors.
+inline constexpr size_t pair_stage_halo_factor = 4;
+// tiles whose neighbor indices span more are read in place
+inline constexpr size_t pair_stage_max_window = size_t(1) << 18;
+}  // namespace internal
+
+// The size of the staged fields of a tile in bytes, 0 disables the tiling.
+inline size_t GetPairTileBytes() {
+  return internal::PairTileBytesRef().load(std::memory_order_relaxed);
+}
+inline void SetPairTileBytes(const size_t bytes) {
+  internal::PairTileBytesRef().store(bytes, std::memory_order_relaxed);
+}
+
+// The L2 cache of one core, 1MB if the size is not reported.
+size_t DetectL2CacheBytes();
+
+// The number of particles of a tile whose staged neighbor fields fit the
+// GetPairTileBytes, 0 if tiling is disabled.
+SizeT PairTileSize(const bool with_derived);
+
+// The fields of the neighbors of the particles [b, e) of a tile, copied in the
+// order of the neighbor indices, with the neighbor lists renumbered into the
+// copies. Only the pair order of the lists is kept, so the sums of a pair loop
+// are the same as in place.
+class PairStage {
+ public:
+  // false if the neighbor indices of the tile span more than
+  // pair_stage_max_window, then the tile is read in place
+  bool Stage(const SavedNeighborsD& sn, const PairFields& fields,
+             const SizeT b, const SizeT e);
+
+  const PairFields& fields() const { return fields_; }
+  // the renumbered neighbors of particle i of the tile
+  SavedNeighborsD::ConstRange neighbors(const SizeT i) const {
+    return SavedNeighborsD::ConstRange(
+        neighbors_.data() + offsets_[i - begin_],
+        neighbors_.data() + offsets_[i - begin_ + 1]);
+  }
+  // the number of staged neighbors
+  SizeT size() const { return pos_.size(); }
+
+ private:
+  SizeT begin_ = 0;
+  // the buffer index of neighbor index first_ + w
+  std::vector<SizeT> local_;
+  std::vector<SizeT> neighbors_;
+  std::vector<SizeT> offsets_;
+  std::vector<Vectord> pos_, vel_;
+  std::vector<double> dty_, prs_, inv_dty_, vol_;
+  PairFields fields_;
+};
+
+// The stages of the calling thread, one per neighbor list of a sweep. They
+// keep their buffers between the tiles and the sweeps.
+PairStage& ThreadPairStage(const int list);
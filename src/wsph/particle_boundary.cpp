@@ -1,29 +1,44 @@
 #include "particle_boundary.hpp"
 
-#include "neighbor/saved_neighbors.hpp"
+#include "pair_loop.hpp"
+#include "parstd/simd.hpp"
+#include "simd_pairs.hpp"
 
 void ParticleBoundary::Interpolate(const Particles& p) {
-  SavedNeighborsD saved(pos(), p.pos());
-#pragma omp parallel for schedule(guided)
-  for (SizeT i = 0; i < size(); ++i) {
-    double dty_loc = 0., renorm = 0.;
-    Vectord vel_loc(0.);
-    for (const SizeT j : saved.neighbors(i)) {
-      const Vectord rij = pos(i) - p.pos(j);
-      const double dist2 = rij * rij, dist = std::sqrt(dist2);
-      const double w = Kernel(dist, p.h());
-      renorm += w;
-      dty_loc += w * p.dty(j);
-      vel_loc += -w * p.vel(j);
-    }
-    if (renorm != 0.) {
-      dty(i) = dty_loc / renorm;
-      prs(i) = ComputePressure(dty(i), p.ref_density(), p.pressure_parameter());
-      vel(i) = ((vel_loc / renorm) * normal(i)) * normal(i);
-    } else {
-      dty(i) = p.ref_density();
-      prs(i) = 0.;
-      vel(i) = 0.;
-    }
+  if (size() == 0) {
+    return;
   }
-}
\ No newline at end of file
+  fluid_neighbors_.Update(pos(), p.pos());
+  DispatchKernel(p.kernel(), p.tabulated_kernel(), p.h(),
+                 [&](const auto& kernel) { Interpolate(kernel, p); });
+}
+
+template <typename Kernel>
+void ParticleBoundary::Interpolate(const Kernel& kernel, const Particles& p) {
+  ForEachPair<InterpolationSums>(
+      size(), fluid_neighbors_, PairFields(p),
+      [&](const PairFields& nb, const SizeT i, const SizeT j, const SizeT,
+          InterpolationSums& s) {
+        const Vectord rij = pos(i) - nb.pos(j);
+        const double w = kernel.WOfDist2(rij * rij);
+        s.renorm += w;
+        s.dty += w * nb.dty(j);
+        s.vel += -w * nb.vel(j);
+      },
+      [&](const SizeT i, const InterpolationSums& s) {
+        if (s.renorm != 0.) {
+          dty(i) = s.dty / s.renorm;
+          prs(i) = ComputePressure(dty(i), p.ref_density(),
+                                   p.pressure_parameter());
+          vel(i) = ((s.vel / s.renorm) * normal(i)) * normal(i);
+        } else {
+          dty(i) = p.ref_density();
+          prs(i) = 0.;
+          vel(i) = 0.;
+        }
+      },
+      [&](const SimdIsa isa, const PairFields& nb, const SizeT i,
+          const SavedNeighborsD::ConstRange neighbors) {
+        return InterpolationPairsSimd(isa, kernel, pos(i), nb, neighbors);
+      });
+}
@@ -22,7 +22,11 @@
 
 #pragma once
 
+#include <tuple>
+#include <utility>
+
 #include "materials.hpp"
+#include "neighbor/saved_neighbors.hpp"
 #include "particles.hpp"
 
 class ParticleBoundary : public Particles {
@@ -31,16 +35,33 @@ class ParticleBoundary : public Particles {
   ParticleBoundary(const MaterialSettings& s, std::vector<Vectord> pos,
                    std::vector<Vectord> normals, std::vector<Vectord> vel)
       : Particles(s, std::move(pos), std::move(vel)) {
-    normal_ = ApplyIndexMap(idx_map(), std::move(normals));
+    normal_ = normals;
+    gather_(idx_map(), normal_);
   }
 
+  // hides Particles::Update to reorder the normals as well
+  void Update() { Reorder(fields()); }
+
   void Interpolate(const Particles& p);
 
-  const std::vector<Vectord>& normal() const { return normal_; }
+  const GpuVector<Vectord>& normal() const { return normal_; }
 
   const Vectord& normal(const SizeT idx) const { return normal_[idx]; }
   Vectord& normal(const SizeT idx) { return normal_[idx]; }
 
+ protected:
+  using Fields = decltype(std::tuple_cat(
+      std::declval<Particles::Fields>(),
+      std::declval<std::tuple<GpuVector<Vectord>&>>()));
+  Fields fields() {
+    return std::tuple_cat(Particles::fields(), std::tie(normal_));
+  }
+
  private:
-  std::vector<Vectord> normal_;
+  template <typename Kernel>
+  void Interpolate(const Kernel& kernel, const Particles& p);
+
+  GpuVector<Vectord> normal_;
+  // fluid neighbors of the boundary particles, kept to reuse their memory
+  SavedNeighborsD fluid_neighbors_;
 };
\ No newline at end of file
@@ -23,13 +23,28 @@
 #pragma once
 
 #include <stdexcept>
+#include <tuple>
 #include <vector>
 
 #include "basic_equations.hpp"
+#include "container/soa_vector.hpp"
 #include "materials.hpp"
+#include "neighbor/field_gather.hpp"
 #include "neighbor/point_cell_list.hpp"
 #include "utils/types.hpp"
 
+// Storage of the velocities. Builds with PARTICLES_SOA keep them as structure
+// of arrays, so the per-particle update loops read and write them with one
+// particle per lane. p.vel(i) then returns a SoaVector::Reference, which is
+// used like a Vectord&. The positions stay an array of Vectord in both
+// layouts, the cell list sorts them and the neighbor search reads them as
+// Vectord.
+#ifdef SOA_ENABLED
+using VelocityVector = SoaVector<double, 3>;
+#else
+using VelocityVector = GpuVector<Vectord>;
+#endif
+
 class Particles {
  public:
   Particles() = default;
@@ -41,9 +56,8 @@ class Particles {
     }
     const double cell_size = 2. * s.dr * s.smoothing_ratio;
     auto [idx_map, points] = PointCellListD::Create(cell_size, std::move(pos));
-    vel = ApplyIndexMap(idx_map, std::move(vel));
-    dty = ApplyIndexMap(idx_map, std::move(dty));
     *this = Particles(s, std::move(points), std::move(vel), std::move(dty));
+    gather_(idx_map, fields());
     idx_map_ = std::move(idx_map);
   }
 
@@ -53,10 +67,15 @@ class Particles {
     *this = Particles(s, std::move(pos), std::move(vel), std::move(dtyinit));
   }
 
-  void Update() {
-    const auto idx_map = pos_.Update();
-    vel_ = ApplyIndexMap(idx_map, std::move(vel_));
-    dty_ = ApplyIndexMap(idx_map, std::move(dty_));
+  void Update() { Reorder(fields()); }
+
+  // Exchanges the positions, velocities and densities with a second state of
+  // the same particle order, the pressure is kept.
+  void SwapState(GpuVector<Vectord>& pos, VelocityVector& vel,
+                 GpuVector<double>& dty) {
+    pos_.SwapPoints(pos);
+    std::swap(vel_, vel);
+    std::swap(dty_, dty);
   }
 
   SizeT size() const { return pos_.size(); }
@@ -65,16 +84,18 @@ class Particles {
   const Vectord& pos(const SizeT idx) const { return pos_[idx]; }
   Vectord& pos(const SizeT idx) { return pos_[idx]; }
 
-  const std::vector<Vectord>& vel() const { return vel_; }
-  std::vector<Vectord>& vel() { return vel_; }
-  const Vectord& vel(const SizeT idx) const { return vel_[idx]; }
-  Vectord& vel(const SizeT idx) { return vel_[idx]; }
+  const VelocityVector& vel() const { return vel_; }
+  VelocityVector& vel() { return vel_; }
+  VelocityVector::const_reference vel(const SizeT idx) const {
+    return vel_[idx];
+  }
+  VelocityVector::reference vel(const SizeT idx) { return vel_[idx]; }
 
-  const std::vector<double>& dty() const { return dty_; }
+  const GpuVector<double>& dty() const { return dty_; }
   const double& dty(const SizeT idx) const { return dty_[idx]; }
   double& dty(const SizeT idx) { return dty_[idx]; }
 
-  const std::vector<double>& prs() const { return prs_; }
+  const GpuVector<double>& prs() const { return prs_; }
   const double& prs(const SizeT idx) const { return prs_[idx]; }
   double& prs(const SizeT idx) { return prs_[idx]; }
 
@@ -86,12 +107,40 @@ class Particles {
   double dr() const { return dr_; }
   double sos() const { return speed_of_sound_; }
   double viscosity() const { return 0.01; }
+  KernelType kernel() const { return kernel_; }
+  bool tabulated_kernel() const { return tabulated_kernel_; }
+
+  const GpuVector<SizeT>& idx_map() const { return idx_map_; }
+
+ protected:
+  // The per-particle fields besides the positions. They are reordered
+  // together with the positions in a single gather, so a new field only has
+  // to be added here. The velocities are gathered as their component arrays
+  // with SOA_ENABLED.
+#ifdef SOA_ENABLED
+  using Fields =
+      std::tuple<GpuVector<double>&, GpuVector<double>&, GpuVector<double>&,
+                 GpuVector<double>&, GpuVector<double>&>;
+  Fields fields() {
+    return std::tuple_cat(vel_.components(), std::tie(dty_, prs_));
+  }
+#else
+  using Fields =
+      std::tuple<GpuVector<Vectord>&, GpuVector<double>&, GpuVector<double>&>;
+  Fields fields() { return std::tie(vel_, dty_, prs_); }
+#endif
+
+  // sorts the positions into the cells and the fields accordingly
+  template <typename Fields>
+  void Reorder(const Fields& fields) {
+    gather_(pos_.Update(), fields);
+  }
 
-  const std::vector<SizeT>& idx_map() const { return idx_map_; }
+  FieldGather gather_;
 
  private:
-  Particles(const MaterialSettings& s, PointCellListD pos,
-            std::vector<Vectord> vel, std::vector<double> dty)
+  Particles(const MaterialSettings& s, PointCellListD pos, VelocityVector vel,
+            GpuVector<double> dty)
       : ref_density_(s.ref_density),
         speed_of_sound_(s.speed_of_sound),
         pressure_parameter_(
@@ -99,6 +148,8 @@ class Particles {
         mass_(std::pow(s.dr, 3) * ref_density_),
         h_(s.dr * s.smoothing_ratio),
         dr_(s.dr),
+        kernel_(s.kernel),
+        tabulated_kernel_(s.tabulated_kernel),
         pos_(std::move(pos)),
         vel_(std::move(vel)),
         dty_(std::move(dty)),
@@ -110,11 +161,13 @@ class Particles {
   double mass_;
   double h_;
   double dr_;
+  KernelType kernel_ = KernelType::kQuadraticSpline;
+  bool tabulated_kernel_ = false;
 
   PointCellListD pos_;
-  std::vector<Vectord> vel_;
-  std::vector<double> dty_;
-  std::vector<double> prs_;
+  VelocityVector vel_;
+  GpuVector<double> dty_;
+  GpuVector<double> prs_;
 
-  std::vector<SizeT> idx_map_;
+  GpuVector<SizeT> idx_map_;
 };
\ No newline at end of file
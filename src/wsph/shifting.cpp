@@ -24,58 +24,75 @@
 
 #include <iostream>  // FIXME
 
-void DpcShifting::Compute(const Domain& d) {
-  ComputePP(true, d.p, d.p, d.p_p_neighbors);
+#include "pair_loop.hpp"
+#include "parstd/simd.hpp"
+#include "simd_pairs.hpp"
 
-  if (d.pb.size() > 0) {
-    ComputePP(false, d.p, d.pb, d.p_pb_neighbors);
-  }
+namespace {
+struct LindSums {
+  Vectord c = 0.;
+  double nr = 0.;
+};
+}  // namespace
+
+void DpcShifting::Compute(const Domain& d) {
+  // reuses the derived fields of a previous operator of the same state
+  if (!d.p_fields.valid()) d.UpdateDerivedFields();
+  // the shifting only uses the kernel through Chi, whose smoothing length is dr
+  DispatchKernel(d.p.kernel(), d.p.tabulated_kernel(), d.p.dr(),
+                 [&](const auto& kernel) {
+                   ComputePP(kernel, true, d.p, d.p, d.p_fields, d.p_fields,
+                             d.p_p_neighbors, d.p_p_pairs);
+                   if (d.pb.size() > 0) {
+                     ComputePP(kernel, false, d.p, d.pb, d.p_fields,
+                               d.pb_fields, d.p_pb_neighbors, d.p_pb_pairs);
+                   }
+                 });
 }
 
-void DpcShifting::ComputePP(const bool overwrite, const Particles& p,
-                            const Particles& np, const SavedNeighborsD& sn) {
-  collision_term_.resize(p.size());
-  repulsive_term_.resize(p.size());
-#pragma omp parallel for schedule(guided)
-  for (SizeT i = 0; i < p.size(); ++i) {
-    Vectord coll = 0.;
-    Vectord repu = 0.;
-    const double prs_i = p.prs(i), vol_i = p.mass() / p.dty(i);
-    for (const SizeT j : sn.neighbors(i)) {
-      const double prs_j = np.prs(j), vol_j = np.mass() / np.dty(j);
-      const Vectord rij = p.pos(i) - np.pos(j);
-      const double dist2 = rij * rij, dist = std::sqrt(dist2);
-      if (dist >= p.dr()) continue;
-
-      const Vectord vij = p.vel(i) - np.vel(j);
-      const double vij_rij = vij * rij;
-      if (vij_rij < 0.) {
-        const Vectord v_coll =
-            -(vij_rij / (dist2 + 0.01 * math::tpow<2>(p.h()))) * rij;
-        double kappa = 1.;
-        if (dist >= 0.5 * p.dr()) {
-          kappa = Chi(dist, p.dr());
-        }
-        coll += kappa * v_coll;
-      } else {
-        constexpr double lambda = 0.1;
-        const double vol_ave = 2.0 * vol_j / (vol_i + vol_j);
-        const double back_prs =
-            Chi(dist, p.dr()) *
-            std::clamp(lambda * std::abs(prs_i + prs_j), prs_min_, prs_max_);
-        repu += (vol_ave * (back_prs / (dist2 + 0.01 * math::tpow<2>(p.h()))) *
-                 rij) /
-                p.dty(i);
-      }
-    }
-    if (overwrite) {
-      collision_term_[i] = coll;
-      repulsive_term_[i] = repu;
-    } else {
-      collision_term_[i] += coll;
-      repulsive_term_[i] += repu;
-    }
+template <typename Kernel>
+void DpcShifting::ComputePP(const Kernel&, const bool overwrite,
+                            const Particles& p, const Particles& np,
+                            const DerivedFields& f, const DerivedFields& nf,
+                            const SavedNeighborsD& sn,
+                            const PairCache& cache) {
+  const ChiPolicy<Kernel> chi(p.dr());
+  const PairFields fields(np, &nf);
+  Resize(p.size());
+  const auto finalize = [&](const SizeT i, const Terms& t) {
+    StoreOrAdd(overwrite, collision_term_[i], t.collision);
+    StoreOrAdd(overwrite, repulsive_term_[i], t.repulsive);
+  };
+  if (cache.valid()) {
+    ForEachPair<Terms>(
+        p.size(), sn, fields,
+        [&](const PairFields& nb, const SizeT i, const SizeT j, const SizeT k,
+            Terms& t) {
+          const PairGeometry& pair = cache.pairs(i)[k];
+          const Vectord rij = pair.rij();
+          const double vij_rij = (p.vel(i) - nb.vel(j)) * rij;
+          AddPair(chi, p, f, nb, i, j, rij, pair.dist * pair.dist, vij_rij,
+                  t);
+        },
+        finalize);
+    return;
   }
+  ForEachPair<Terms>(
+      p.size(), sn, fields,
+      [&](const PairFields& nb, const SizeT i, const SizeT j, const SizeT,
+          Terms& t) {
+        const Vectord rij = p.pos(i) - nb.pos(j);
+        const double dist2 = rij * rij;
+        const double vij_rij = (p.vel(i) - nb.vel(j)) * rij;
+        AddPair(chi, p, f, nb, i, j, rij, dist2, vij_rij, t);
+      },
+      finalize,
+      [&](const SimdIsa isa, const PairFields& nb, const SizeT i,
+          const SavedNeighborsD::ConstRange neighbors) {
+        const DpcSums s = DpcPairsSimd(isa, chi, p, f, nb, prs_min_,
+                                       prs_max_, i, neighbors);
+        return Terms{s.collision, s.repulsive};
+      });
 }
 
 void DpcShifting::Apply(const double dt, Domain& d) {
@@ -85,11 +102,17 @@ void DpcShifting::Apply(const double dt, Domain& d) {
     d.p.vel(i) += delta;
     d.SetFluidPos(i, d.p.pos(i) + dt * delta);
   }
+  d.InvalidateCaches();
 }
 
 void LindShifting::Compute(const Domain& d) {
-  ComputePP(true, d.p, d.p, d.p_p_neighbors);
-  if (d.pb.size() > 0) ComputePP(false, d.p, d.pb, d.p_pb_neighbors);
+  DispatchKernel(d.p.kernel(), d.p.tabulated_kernel(), d.p.h(),
+                 [&](const auto& kernel) {
+                   ComputePP(kernel, true, d.p, d.p, d.p_p_neighbors);
+                   if (d.pb.size() > 0) {
+                     ComputePP(kernel, false, d.p, d.pb, d.p_pb_neighbors);
+                   }
+                 });
 }
 
 void LindShifting::Apply(const double dt, Domain& d) {
@@ -97,32 +120,31 @@ void LindShifting::Apply(const double dt, Domain& d) {
   for (SizeT i = 0; i < d.p.size(); ++i) {
     d.SetFluidPos(i, d.p.pos(i) + dt * delta_r_[i]);
   }
+  d.InvalidateCaches();
 }
 
-void LindShifting::ComputePP(const bool overwrite, const Particles& p,
-                             const Particles& np, const SavedNeighborsD& sn) {
+template <typename Kernel>
+void LindShifting::ComputePP(const Kernel& kernel, const bool overwrite,
+                             const Particles& p, const Particles& np,
+                             const SavedNeighborsD& sn) {
   delta_r_.resize(p.size());
-  // #pragma omp parallel for schedule(guided)
-  for (SizeT i = 0; i < p.size(); ++i) {
-    Vectord c = 0.;
-    double nr = 0.;
-    for (const SizeT j : sn.neighbors(i)) {
-      const Vectord rij = p.pos(i) - np.pos(j);
-      const double dist2 = rij * rij, dist = std::sqrt(dist2);
-      const double vol = np.dty(j) / np.mass();
-      const Vectord wg = KernelGradient(dist, p.h()) * rij;
-
-      c += vol * wg;
-      nr += (vol * rij) * wg;
-    }
-    const double A_fsc = (nr - A_fst) / (A_fsm - A_fst);
-
-    Vectord shift = -A * p.h() * c;
-    if (nr - A_fst < 0) shift *= A_fsc;
-    if (overwrite) {
-      delta_r_[i] = shift;
-    } else {
-      delta_r_[i] += shift;
-    }
-  }
+  ForEachPair<LindSums>(
+      p.size(), sn, PairFields(np),
+      [&](const PairFields& nb, const SizeT i, const SizeT j, const SizeT,
+          LindSums& s) {
+        const Vectord rij = p.pos(i) - nb.pos(j);
+        const double dist2 = rij * rij, dist = std::sqrt(dist2);
+        const double vol = nb.dty(j) / nb.mass();
+        const Vectord wg = kernel.Gradient(dist) * rij;
+
+        s.c += vol * wg;
+        s.nr += (vol * rij) * wg;
+      },
+      [&](const SizeT i, const LindSums& s) {
+        const double A_fsc = (s.nr - A_fst) / (A_fsm - A_fst);
+
+        Vectord shift = -A * p.h() * s.c;
+        if (s.nr - A_fst < 0) shift *= A_fsc;
+        StoreOrAdd(overwrite, delta_r_[i], shift);
+      });
 }
@@ -22,8 +22,12 @@
 
 #pragma once
 
+#include <algorithm>
+#include <cmath>
+
 #include "basic_equations.hpp"
 #include "domain.hpp"
+#include "pair_fields.hpp"
 
 // From Jandaghian et al, 2021: Stability and accuracy of the
 // weakly compressible SPH with particle regularization techniques
@@ -39,6 +43,12 @@ class NoShifting {
 
 class DpcShifting {
  public:
+  // the shifting terms of one particle, summed over a set of neighbors
+  struct Terms {
+    Vectord collision = 0.;
+    Vectord repulsive = 0.;
+  };
+
   DpcShifting() = default;
 
   void Compute(const Domain& d);
@@ -50,14 +60,69 @@ class DpcShifting {
     prs_max_ = prs_max;
   }
 
+  // Adds the terms of neighbor j in nb to the terms of particle i, with the
+  // derived fields f of p. Used by Compute and by sweeps which
+  // computed the pair geometry already, e.g. the RHS of the corrector stage.
+  // Only the squared distance is used, so a tabulated Chi needs no sqrt.
+  template <typename Chi>
+  DEVICE void AddPair(const Chi& chi, const Particles& p,
+                      const DerivedFields& f, const PairFields& nb,
+                      const SizeT i, const SizeT j, const Vectord& rij,
+                      const double dist2, const double vij_rij,
+                      Terms& t) const {
+    const double dr2 = math::tpow<2>(p.dr());
+    if (dist2 >= dr2) return;
+    const double inv_dist2_eta2 = 1. / (dist2 + 0.01 * math::tpow<2>(p.h()));
+    if (vij_rij < 0.) {
+      const Vectord v_coll = -(vij_rij * inv_dist2_eta2) * rij;
+      double kappa = 1.;
+      if (dist2 >= 0.25 * dr2) {
+        kappa = chi.OfDist2(dist2);
+      }
+      t.collision += kappa * v_coll;
+    } else {
+      constexpr double lambda = 0.1;
+      const double vol_i = f.vol(i), vol_j = nb.vol(j);
+      const double vol_ave = 2.0 * vol_j / (vol_i + vol_j);
+      const double back_prs =
+          chi.OfDist2(dist2) *
+          std::clamp(lambda * std::abs(p.prs(i) + nb.prs(j)), prs_min_,
+                     prs_max_);
+      t.repulsive +=
+          (vol_ave * back_prs * inv_dist2_eta2 * f.inv_dty(i)) * rij;
+    }
+  }
+
+  void Resize(const SizeT n) {
+    collision_term_.resize(n);
+    repulsive_term_.resize(n);
+  }
+
+  // stores the terms of particle i summed over its fluid and boundary
+  // neighbors, in the order of the separate sweeps of Compute
+  void Set(const SizeT i, const Terms& fluid, const Terms* boundary) {
+    collision_term_[i] = fluid.collision;
+    repulsive_term_[i] = fluid.repulsive;
+    if (boundary) {
+      collision_term_[i] += boundary->collision;
+      repulsive_term_[i] += boundary->repulsive;
+    }
+  }
+
+  const GpuVector<Vectord>& collision_term() const { return collision_term_; }
+  const GpuVector<Vectord>& repulsive_term() const { return repulsive_term_; }
+
  private:
-  void ComputePP(const bool overwrite, const Particles& p, const Particles& np,
-                 const SavedNeighborsD& sn);
+  template <typename Kernel>
+  void ComputePP(const Kernel& kernel, const bool overwrite,
+                 const Particles& p, const Particles& np,
+                 const DerivedFields& f, const DerivedFields& nf,
+                 const SavedNeighborsD& sn, const PairCache& cache);
 
   double prs_min_ = 0;
   double prs_max_ = std::numeric_limits<double>::max();
-  std::vector<Vectord> collision_term_;
-  std::vector<Vectord> repulsive_term_;
+  GpuVector<Vectord> collision_term_;
+  GpuVector<Vectord> repulsive_term_;
 };
 
 class LindShifting {
@@ -69,12 +134,14 @@ class LindShifting {
   void Apply(const double dt, Domain& d);
 
  private:
-  void ComputePP(const bool overwrite, const Particles& p, const Particles& np,
+  template <typename Kernel>
+  void ComputePP(const Kernel& kernel, const bool overwrite,
+                 const Particles& p, const Particles& np,
                  const SavedNeighborsD& sn);
 
   static constexpr double A = 2.;
   static constexpr double A_fst = 2.75;
   static constexpr double A_fsm = 3.;
 
-  std::vector<Vectord> delta_r_;
+  GpuVector<Vectord> delta_r_;
 };
\ No newline at end of file
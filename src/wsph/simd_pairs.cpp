@@ -0,0 +1,382 @@
+// MIT License
+
+// Copyright (c) 2023 Marc Hartung
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "simd_pairs.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "basic_equations.hpp"
+
+// compiled with the options of CMakeLists.txt which let the loops vectorize
+
+namespace {
+// The strides of the hot fields of the separate arrays, of the separate
+// arrays with structure of arrays velocities and of the PairRecords, as
+// compile time constants of the loops.
+struct ArrayStrides {
+  static constexpr SizeT vec = 3, vel = 3, scalar = 1;
+};
+struct SoaStrides {
+  static constexpr SizeT vec = 3, vel = 1, scalar = 1;
+};
+struct RecordStrides {
+  static constexpr SizeT vec = PairFields::record_stride, vel = vec,
+                         scalar = vec;
+};
+
+// Calls f with the strides of nb. The velocities of the Particles are only
+// stored as structure of arrays with SOA_ENABLED, so the loops for them are
+// left out of the other builds.
+template <typename F>
+decltype(auto) DispatchStrides(const PairFields& nb, F&& f) {
+  if (nb.packed()) {
+    return f(RecordStrides());
+  }
+#ifdef SOA_ENABLED
+  if (nb.vel_stride() == 1) {
+    return f(SoaStrides());
+  }
+#endif
+  return f(ArrayStrides());
+}
+
+// With fill_pairs, the geometry of pair k is written to pairs[k] for the
+// PairCache.
+template <typename Strides, bool fluid_neighbor, bool fill_pairs,
+          typename Kernel>
+DEVICE RhsSums RhsPairs(const Kernel& kernel, const Particles& p,
+                        const DerivedFields& f, const PairFields& fields,
+                        const SizeT i,
+                        const SavedNeighborsD::ConstRange neighbors,
+                        PairGeometry* pairs) {
+  RhsSums s;
+  if (neighbors.empty()) return s;
+  const SizeT* nb = neighbors.begin();
+  const SizeT n = neighbors.size();
+  const double* pos = fields.pos();
+  const double* vel_x = fields.vel_component(0);
+  const double* vel_y = fields.vel_component(1);
+  const double* vel_z = fields.vel_component(2);
+  const double* dty = fields.dty();
+  const double* prs = fields.prs();
+  const double* inv_dty = fields.inv_dty();
+  const double* vol = fields.vol();
+  const Vectord pos_i = p.pos(i), vel_i = p.vel(i);
+  const double dty_i = p.dty(i), prs_i = p.prs(i), inv_dty_i = f.inv_dty(i);
+  const double h = p.h(), eta2 = 0.01 * math::tpow<2>(h);
+  const double mass = fields.mass(), visc_fac = mass * p.viscosity() * p.sos();
+  double ax = 0., ay = 0., az = 0., dtyD = 0., dtyDD = 0., courant = 0.;
+#pragma omp simd reduction(+ : ax, ay, az, dtyD, dtyDD) reduction(max : courant)
+  for (SizeT k = 0; k < n; ++k) {
+    const size_t j = nb[k];
+    const size_t jv = Strides::vec * j, jw = Strides::vel * j,
+                 js = Strides::scalar * j;
+    const double rx = pos_i[0] - pos[jv], ry = pos_i[1] - pos[jv + 1],
+                 rz = pos_i[2] - pos[jv + 2];
+    const double dist2 = rx * rx + ry * ry + rz * rz;
+    const double inv_dist2_eta2 = 1. / (dist2 + eta2);
+    // the kernel gradient over the distance, the gradient is g * rij. Only
+    // the density diffusion and the pair cache need the distance itself.
+    const double g = kernel.GradientOverDist(dist2);
+    const double vij_rij = (vel_i[0] - vel_x[jw]) * rx +
+                           (vel_i[1] - vel_y[jw]) * ry +
+                           (vel_i[2] - vel_z[jw]) * rz;
+    const double visc = h * vij_rij * inv_dist2_eta2;
+    // the viscosity only acts between approaching particles
+    const double viscous = visc_fac * visc / (0.5 * (dty_i + dty[js]));
+    const double a =
+        (-mass * (prs_i + prs[js]) * (inv_dty_i * inv_dty[j]) +
+         (vij_rij < 0. ? viscous : 0.)) *
+        g;
+    ax += a * rx;
+    ay += a * ry;
+    az += a * rz;
+    dtyD += dty_i * vol[j] * (g * vij_rij);
+    if constexpr (fluid_neighbor) {
+      const double wg = g * std::sqrt(dist2);
+      dtyDD += 2. * 0.1 * (dty[js] - dty_i) * inv_dist2_eta2 * (wg * dist2) *
+               vol[j];
+    }
+    courant = std::max(courant, std::abs(visc));
+    if constexpr (fill_pairs) {
+      const double dist = std::sqrt(dist2), inv_dist = 1. / dist;
+      pairs[k] = {Vectorf(rx * inv_dist, ry * inv_dist, rz * inv_dist),
+                  static_cast<float>(dist), static_cast<float>(g * dist)};
+    }
+  }
+  s.acc = Vectord(ax, ay, az);
+  s.dtyD = dtyD;
+  s.dtyDD = dtyDD;
+  s.courant = courant;
+  return s;
+}
+
+template <typename Strides, typename Chi>
+DEVICE DpcSums DpcPairs(const Chi& chi, const Particles& p,
+                        const DerivedFields& f, const PairFields& fields,
+                        const double prs_min, const double prs_max,
+                        const SizeT i,
+                        const SavedNeighborsD::ConstRange neighbors) {
+  DpcSums s;
+  if (neighbors.empty()) return s;
+  constexpr double lambda = 0.1;
+  constexpr SizeT block_size = 64;
+  const SizeT* nb = neighbors.begin();
+  const SizeT n = neighbors.size();
+  const double* pos = fields.pos();
+  const double* vel_x = fields.vel_component(0);
+  const double* vel_y = fields.vel_component(1);
+  const double* vel_z = fields.vel_component(2);
+  const double* prs = fields.prs();
+  const double* vol = fields.vol();
+  const Vectord pos_i = p.pos(i), vel_i = p.vel(i);
+  const double prs_i = p.prs(i), vol_i = f.vol(i), inv_dty_i = f.inv_dty(i);
+  const double dr2 = math::tpow<2>(p.dr()), eta2 = 0.01 * math::tpow<2>(p.h());
+  double cx = 0., cy = 0., cz = 0., rpx = 0., rpy = 0., rpz = 0.;
+  // Most neighbors lie beyond dr. They are dropped by a compaction of every
+  // block of neighbors, so the vectorized loop only computes the terms of
+  // the near ones.
+  SizeT near[block_size];
+  for (SizeT b = 0; b < n; b += block_size) {
+    const SizeT e = std::min(n, b + block_size);
+    SizeT num_near = 0;
+    for (SizeT k = b; k < e; ++k) {
+      const size_t j = nb[k], jv = Strides::vec * j;
+      const double rx = pos_i[0] - pos[jv], ry = pos_i[1] - pos[jv + 1],
+                   rz = pos_i[2] - pos[jv + 2];
+      near[num_near] = j;
+      num_near += rx * rx + ry * ry + rz * rz < dr2;
+    }
+#pragma omp simd reduction(+ : cx, cy, cz, rpx, rpy, rpz)
+    for (SizeT k = 0; k < num_near; ++k) {
+      const size_t j = near[k];
+      const size_t jv = Strides::vec * j, jw = Strides::vel * j,
+                   js = Strides::scalar * j;
+      const double rx = pos_i[0] - pos[jv], ry = pos_i[1] - pos[jv + 1],
+                   rz = pos_i[2] - pos[jv + 2];
+      const double dist2 = rx * rx + ry * ry + rz * rz;
+      const double inv_dist2_eta2 = 1. / (dist2 + eta2);
+      const double vij_rij = (vel_i[0] - vel_x[jw]) * rx +
+                             (vel_i[1] - vel_y[jw]) * ry +
+                             (vel_i[2] - vel_z[jw]) * rz;
+      const double chi_ij = chi.OfDist2(dist2);
+      const double kappa = dist2 >= 0.25 * dr2 ? chi_ij : 1.;
+      const double collision = -kappa * vij_rij * inv_dist2_eta2;
+      const double back_prs =
+          chi_ij * std::min(std::max(lambda * std::abs(prs_i + prs[js]),
+                                     prs_min),
+                            prs_max);
+      const double vol_ave = 2.0 * vol[j] / (vol_i + vol[j]);
+      const double repulsive =
+          vol_ave * back_prs * inv_dist2_eta2 * inv_dty_i;
+      const bool approaching = vij_rij < 0.;
+      const double c = approaching ? collision : 0.;
+      const double r = approaching ? 0. : repulsive;
+      cx += c * rx;
+      cy += c * ry;
+      cz += c * rz;
+      rpx += r * rx;
+      rpy += r * ry;
+      rpz += r * rz;
+    }
+  }
+  s.collision = Vectord(cx, cy, cz);
+  s.repulsive = Vectord(rpx, rpy, rpz);
+  return s;
+}
+
+template <typename Strides, typename Kernel>
+DEVICE InterpolationSums InterpolationPairs(
+    const Kernel& kernel, const Vectord& pos_i, const PairFields& fields,
+    const SavedNeighborsD::ConstRange neighbors) {
+  InterpolationSums s;
+  if (neighbors.empty()) return s;
+  const SizeT* nb = neighbors.begin();
+  const SizeT n = neighbors.size();
+  const double* pos = fields.pos();
+  const double* vel_x = fields.vel_component(0);
+  const double* vel_y = fields.vel_component(1);
+  const double* vel_z = fields.vel_component(2);
+  const double* dty = fields.dty();
+  double renorm = 0., dty_sum = 0., vx = 0., vy = 0., vz = 0.;
+#pragma omp simd reduction(+ : renorm, dty_sum, vx, vy, vz)
+  for (SizeT k = 0; k < n; ++k) {
+    const size_t j = nb[k];
+    const size_t jv = Strides::vec * j, jw = Strides::vel * j,
+                 js = Strides::scalar * j;
+    const double rx = pos_i[0] - pos[jv], ry = pos_i[1] - pos[jv + 1],
+                 rz = pos_i[2] - pos[jv + 2];
+    const double w = kernel.WOfDist2(rx * rx + ry * ry + rz * rz);
+    renorm += w;
+    dty_sum += w * dty[js];
+    vx -= w * vel_x[jw];
+    vy -= w * vel_y[jw];
+    vz -= w * vel_z[jw];
+  }
+  s.renorm = renorm;
+  s.dty = dty_sum;
+  s.vel = Vectord(vx, vy, vz);
+  return s;
+}
+
+// the loops compiled for the instruction sets, the bodies are inlined
+template <typename Strides, bool fluid_neighbor, bool fill_pairs,
+          typename... Args>
+TARGET_AVX2 RhsSums RhsPairsAvx2(const Args&... args) {
+  return RhsPairs<Strides, fluid_neighbor, fill_pairs>(args...);
+}
+template <typename Strides, bool fluid_neighbor, bool fill_pairs,
+          typename... Args>
+TARGET_AVX512 RhsSums RhsPairsAvx512(const Args&... args) {
+  return RhsPairs<Strides, fluid_neighbor, fill_pairs>(args...);
+}
+template <typename Strides, typename... Args>
+TARGET_AVX2 DpcSums DpcPairsAvx2(const Args&... args) {
+  return DpcPairs<Strides>(args...);
+}
+template <typename Strides, typename... Args>
+TARGET_AVX512 DpcSums DpcPairsAvx512(const Args&... args) {
+  return DpcPairs<Strides>(args...);
+}
+template <typename Strides, typename... Args>
+TARGET_AVX2 InterpolationSums InterpolationPairsAvx2(const Args&... args) {
+  return InterpolationPairs<Strides>(args...);
+}
+template <typename Strides, typename... Args>
+TARGET_AVX512 InterpolationSums InterpolationPairsAvx512(const Args&... args) {
+  return InterpolationPairs<Strides>(args...);
+}
+
+template <typename Strides, bool fluid_neighbor, bool fill_pairs,
+          typename Kernel>
+RhsSums RhsPairsIsa(const SimdIsa isa, const Kernel& kernel,
+                    const Particles& p, const DerivedFields& f,
+                    const PairFields& nb, const SizeT i,
+                    const SavedNeighborsD::ConstRange neighbors,
+                    PairGeometry* pairs) {
+  if (isa == SimdIsa::kAvx512) {
+    return RhsPairsAvx512<Strides, fluid_neighbor, fill_pairs>(
+        kernel, p, f, nb, i, neighbors, pairs);
+  }
+  return RhsPairsAvx2<Strides, fluid_neighbor, fill_pairs>(kernel, p, f, nb,
+                                                           i, neighbors, pairs);
+}
+
+template <typename Strides, typename Kernel>
+RhsSums RhsPairsIsa(const SimdIsa isa, const bool fluid_neighbor,
+                    const Kernel& kernel, const Particles& p,
+                    const DerivedFields& f, const PairFields& nb,
+                    const SizeT i,
+                    const SavedNeighborsD::ConstRange neighbors,
+                    PairGeometry* pairs) {
+  if (fluid_neighbor) {
+    return pairs ? RhsPairsIsa<Strides, true, true>(isa, kernel, p, f, nb, i,
+                                                    neighbors, pairs)
+                 : RhsPairsIsa<Strides, true, false>(isa, kernel, p, f, nb, i,
+                                                     neighbors, pairs);
+  }
+  return pairs ? RhsPairsIsa<Strides, false, true>(isa, kernel, p, f, nb, i,
+                                                   neighbors, pairs)
+               : RhsPairsIsa<Strides, false, false>(isa, kernel, p, f, nb, i,
+                                                    neighbors, pairs);
+}
+
+template <typename Strides, typename Chi>
+DpcSums DpcPairsIsa(const SimdIsa isa, const Chi& chi, const Particles& p,
+                    const DerivedFields& f, const PairFields& nb,
+                    const double prs_min, const double prs_max,
+                    const SizeT i,
+                    const SavedNeighborsD::ConstRange neighbors) {
+  if (isa == SimdIsa::kAvx512) {
+    return DpcPairsAvx512<Strides>(chi, p, f, nb, prs_min, prs_max, i,
+                                   neighbors);
+  }
+  return DpcPairsAvx2<Strides>(chi, p, f, nb, prs_min, prs_max, i,
+                               neighbors);
+}
+
+template <typename Strides, typename Kernel>
+InterpolationSums InterpolationPairsIsa(
+    const SimdIsa isa, const Kernel& kernel, const Vectord& pos_i,
+    const PairFields& nb, const SavedNeighborsD::ConstRange neighbors) {
+  if (isa == SimdIsa::kAvx512) {
+    return InterpolationPairsAvx512<Strides>(kernel, pos_i, nb, neighbors);
+  }
+  return InterpolationPairsAvx2<Strides>(kernel, pos_i, nb, neighbors);
+}
+}  // namespace
+
+template <typename Kernel>
+RhsSums RhsPairsSimd(const SimdIsa isa, const bool fluid_neighbor,
+                     const Kernel& kernel, const Particles& p,
+                     const DerivedFields& f, const PairFields& nb,
+                     const SizeT i,
+                     const SavedNeighborsD::ConstRange neighbors,
+                     PairGeometry* pairs) {
+  return DispatchStrides(nb, [&](const auto strides) {
+    return RhsPairsIsa<decltype(strides)>(isa, fluid_neighbor, kernel, p, f,
+                                          nb, i, neighbors, pairs);
+  });
+}
+
+template <typename Chi>
+DpcSums DpcPairsSimd(const SimdIsa isa, const Chi& chi, const Particles& p,
+                     const DerivedFields& f, const PairFields& nb,
+                     const double prs_min, const double prs_max,
+                     const SizeT i,
+                     const SavedNeighborsD::ConstRange neighbors) {
+  return DispatchStrides(nb, [&](const auto strides) {
+    return DpcPairsIsa<decltype(strides)>(isa, chi, p, f, nb, prs_min, prs_max,
+                                          i, neighbors);
+  });
+}
+
+template <typename Kernel>
+InterpolationSums InterpolationPairsSimd(
+    const SimdIsa isa, const Kernel& kernel, const Vectord& pos_i,
+    const PairFields& nb, const SavedNeighborsD::ConstRange neighbors) {
+  return DispatchStrides(nb, [&](const auto strides) {
+    return InterpolationPairsIsa<decltype(strides)>(isa, kernel, pos_i, nb,
+                                                    neighbors);
+  });
+}
+
+#define INSTANTIATE_SIMD_PAIRS(Kernel)                                       \
+  template RhsSums RhsPairsSimd(SimdIsa, bool, const Kernel&,                \
+                                const Particles&, const DerivedFields&,      \
+                                const PairFields&, SizeT,                    \
+                                SavedNeighborsD::ConstRange, PairGeometry*); \
+  template DpcSums DpcPairsSimd(SimdIsa, const ChiPolicy<Kernel>&,           \
+                                const Particles&, const DerivedFields&,      \
+                                const PairFields&, double, double, SizeT,    \
+                                SavedNeighborsD::ConstRange);                \
+  template InterpolationSums InterpolationPairsSimd(                         \
+      SimdIsa, const Kernel&, const Vectord&, const PairFields&,             \
+      SavedNeighborsD::ConstRange);
+
+INSTANTIATE_SIMD_PAIRS(WendlandPolicy)
+INSTANTIATE_SIMD_PAIRS(CubicSplinePolicy)
+INSTANTIATE_SIMD_PAIRS(QuadraticSplinePolicy)
+INSTANTIATE_SIMD_PAIRS(TabulatedPolicy<WendlandPolicy>)
+INSTANTIATE_SIMD_PAIRS(TabulatedPolicy<CubicSplinePolicy>)
+INSTANTIATE_SIMD_PAIRS(TabulatedPolicy<QuadraticSplinePolicy>)
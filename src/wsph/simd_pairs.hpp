@@ -0,0 +1,82 @@
+// MIT License
+
+// Copyright (c) 2023 Marc Hartung
+
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "derived_fields.hpp"
+#include "neighbor/pair_cache.hpp"
+#include "neighbor/saved_neighbors.hpp"
+#include "pair_fields.hpp"
+#include "parstd/simd.hpp"
+#include "particles.hpp"
+#include "utils/types.hpp"
+
+// Vectorized loops over the neighbors of one particle for SimdIsa::kAvx2 and
+// kAvx512, reading the neighbors from the PairFields nb. The branches of the
+// scalar loops are replaced by selects, so the compiler processes 4 or 8
+// neighbors per iteration and gathers their fields. The lanes are summed in a
+// different order than the scalar loops, the results differ by round-off.
+
+// the RHS sums of BasicWeaklyRhs
+struct RhsSums {
+  Vectord acc = 0.;
+  double dtyD = 0.;
+  // density diffusion, only summed for fluid neighbors
+  double dtyDD = 0.;
+  // maximum of the viscous Courant term
+  double courant = 0.;
+};
+
+// If pairs is not null, the geometry of the pair of neighbor k is written to
+// pairs[k], see PairCache.
+template <typename Kernel>
+RhsSums RhsPairsSimd(const SimdIsa isa, const bool fluid_neighbor,
+                     const Kernel& kernel, const Particles& p,
+                     const DerivedFields& f, const PairFields& nb,
+                     const SizeT i,
+                     const SavedNeighborsD::ConstRange neighbors,
+                     PairGeometry* pairs = nullptr);
+
+// the terms of DpcShifting, chi is the ChiPolicy of the kernel
+struct DpcSums {
+  Vectord collision = 0.;
+  Vectord repulsive = 0.;
+};
+
+template <typename Chi>
+DpcSums DpcPairsSimd(const SimdIsa isa, const Chi& chi, const Particles& p,
+                     const DerivedFields& f, const PairFields& nb,
+                     const double prs_min, const double prs_max,
+                     const SizeT i,
+                     const SavedNeighborsD::ConstRange neighbors);
+
+// the kernel weighted sums of ParticleBoundary::Interpolate
+struct InterpolationSums {
+  double renorm = 0.;
+  double dty = 0.;
+  Vectord vel = 0.;
+};
+
+template <typename Kernel>
+InterpolationSums InterpolationPairsSimd(
+    const SimdIsa isa, const Kernel& kernel, const Vectord& pos_i,
+    const PairFields& nb, const SavedNeighborsD::ConstRange neighbors);
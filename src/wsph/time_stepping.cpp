@@ -24,13 +24,41 @@
 
 #include <omp.h>
 
+#include <functional>
 #include <iostream>
+#include <limits>
+#include <tuple>
+
+#include "parstd/reduce.hpp"
+#include "parstd/step_arena.hpp"
+
+// Maxima of the derivatives and fields and the velocity sum of a step,
+// computed in a single pass over the particles.
+static std::tuple<Vectord, double, double, double, Vectord> StepDiagnostics(
+    const Derivative& derivative, const Particles& p) {
+  const auto longer = [](const Vectord a, const Vectord b) {
+    return (a * a < b * b) ? b : a;
+  };
+  return TransformReduce(
+      p.size(),
+      std::tuple(Vectord(0.), std::numeric_limits<double>::lowest(),
+                 std::numeric_limits<double>::lowest(),
+                 std::numeric_limits<double>::lowest(), Vectord(0.)),
+      std::tuple(longer, MaxOp(), MaxOp(), MaxOp(), std::plus<>()),
+      [&](const SizeT i) {
+        return std::tuple(derivative.acc[i], derivative.dtyD[i], p.prs(i),
+                          p.dty(i), p.vel(i));
+      });
+}
 
 void ForwardEuler::TimeStep(const double dt, Domain& d) {
   shifting_.SetPrs(ComputePressure(d.p.ref_density() * 0.8, d.p.ref_density(),
                                    d.p.pressure_parameter()),
                    ComputePressure(d.p.ref_density() * 1.2, d.p.ref_density(),
                                    d.p.pressure_parameter()));
+  // the shifting reads the pair geometry of the RHS if the PairCachePolicy
+  // enables the cache
+  d.PlanPairCache(1);
   const double t_start = omp_get_wtime();
   SizeT num_steps = 0;
   double stepped_time = 0.;
@@ -45,22 +73,19 @@ void ForwardEuler::TimeStep(const double dt, Domain& d) {
     d.Update();
     stepped_time += sub_dt;
     ++num_steps;
-    std::cout << "sub dt: " << sub_dt << " max acc: "
-              << *std::max_element(
-                     derivative_.acc.begin(), derivative_.acc.end(),
-                     [](auto a, auto b) { return Length(a) < Length(b); })
-              << " max dtyD: "
-              << *std::max_element(derivative_.dtyD.begin(),
-                                   derivative_.dtyD.end())
-              << " max prs: "
-              << *std::max_element(d.p.prs().begin(), d.p.prs().end())
-              << " max dty: "
-              << *std::max_element(d.p.dty().begin(), d.p.dty().end()) << "\n";
+    const auto [max_acc, max_dtyD, max_prs, max_dty, sum_vel] =
+        StepDiagnostics(derivative_, d.p);
+    std::cout << "sub dt: " << sub_dt << " max acc: " << max_acc
+              << " max dtyD: " << max_dtyD << " max prs: " << max_prs
+              << " max dty: " << max_dty << " sum vel:" << sum_vel << "\n";
+    GetStepArena().Reset();
   } while (stepped_time < dt);
 
   std::cout << "\navg dt: " << dt / num_steps << " | num steps: " << num_steps
             << " | step time: "
-            << 1000. * (omp_get_wtime() - t_start) / num_steps << "ms \n";
+            << 1000. * (omp_get_wtime() - t_start) / num_steps
+            << "ms | scratch high water: "
+            << GetStepArena().HighWaterMark() / 1e6 << "MB\n";
 }
 
 void DualSPHysicsVerletTS::TimeStep(const double dt, Domain& d) {
@@ -73,33 +98,52 @@ void DualSPHysicsVerletTS::TimeStep(const double dt, Domain& d) {
     const double sub_dt = std::min(rhs_.ComputeMaxDt(d, derivative_),
                                    std::max(dt - stepped_time, 1.e-14));
 
-    init_state_.Set(d.p);
-    derivative_.Step(sub_dt / 2., gravity_, d);
+    IntegratePredictorStep(sub_dt / 2., d);
     d.pb.Interpolate(d.p);
-    rhs_.Compute(d, derivative_);
-    IntegrateFinalStep(sub_dt, d);
-    d.Update();
-    shifting_.Compute(d);
+    if (fused_shifting_) {
+      rhs_.Compute(d, derivative_, shifting_);
+      IntegrateFinalStep(sub_dt, d);
+    } else {
+      rhs_.Compute(d, derivative_);
+      IntegrateFinalStep(sub_dt, d);
+      d.Update();
+      shifting_.Compute(d);
+    }
     shifting_.Apply(sub_dt, d);
     d.Update();
     stepped_time += sub_dt;
     ++num_steps;
+    GetStepArena().Reset();
   } while (stepped_time < dt);
 
-  std::cout
-      << "sub dt: " << dt / num_steps << " max acc: "
-      << *std::max_element(derivative_.acc.begin(), derivative_.acc.end(),
-                           [](auto a, auto b) { return Length(a) < Length(b); })
-      << " max dtyD: "
-      << *std::max_element(derivative_.dtyD.begin(), derivative_.dtyD.end())
-      << " max prs: " << *std::max_element(d.p.prs().begin(), d.p.prs().end())
-      << " max dty: " << *std::max_element(d.p.dty().begin(), d.p.dty().end())
-      << " sum vel:"
-      << std::accumulate(d.p.vel().begin(), d.p.vel().end(), Vectord(0.))
-      << "\n";
+  const auto [max_acc, max_dtyD, max_prs, max_dty, sum_vel] =
+      StepDiagnostics(derivative_, d.p);
+  std::cout << "sub dt: " << dt / num_steps << " max acc: " << max_acc
+            << " max dtyD: " << max_dtyD << " max prs: " << max_prs
+            << " max dty: " << max_dty << " sum vel:" << sum_vel << "\n";
   std::cout << "\navg dt: " << dt / num_steps << " | num steps: " << num_steps
             << " | step time: "
-            << 1000. * (omp_get_wtime() - t_start) / num_steps << "ms \n";
+            << 1000. * (omp_get_wtime() - t_start) / num_steps
+            << "ms | scratch high water: "
+            << GetStepArena().HighWaterMark() / 1e6 << "MB\n";
+}
+
+// Derivative::Step into the second buffer, followed by the swap. Like
+// SetFluidPos, the positions are assigned without updating the cells.
+void DualSPHysicsVerletTS::IntegratePredictorStep(const double dt, Domain& d) {
+  init_state_.Resize(d.p.size());
+#pragma omp parallel for schedule(static)
+  for (SizeT i = 0; i < d.p.size(); ++i) {
+    const double dty = d.p.dty(i) + dt * derivative_.dtyD[i];
+    const Vectord vel = d.p.vel(i) + dt * (derivative_.acc[i] + gravity_);
+    init_state_.dty[i] = dty;
+    init_state_.vel[i] = vel;
+    init_state_.pos[i] = d.p.pos(i) + dt * vel;
+    d.p.prs(i) =
+        ComputePressure(dty, d.p.ref_density(), d.p.pressure_parameter());
+  }
+  init_state_.Swap(d.p);
+  d.InvalidateCaches();
 }
 
 void DualSPHysicsVerletTS::IntegrateFinalStep(const double dt, Domain& d) {
@@ -112,4 +156,5 @@ void DualSPHysicsVerletTS::IntegrateFinalStep(const double dt, Domain& d) {
     const double eps = -(derivative_.dtyD[i] / d.p.dty(i)) * dt;
     d.p.dty(i) = init_state_.dty[i] * ((2. - eps) / (2. + eps));
   }
+  d.InvalidateCaches();
 }
@@ -30,16 +30,22 @@
 #include "shifting.hpp"
 #include "utils/types.hpp"
 
+// Second buffer of the integrated particle fields. The predictor writes the
+// new state into it and swaps it with the particles, afterwards it holds the
+// state of the step start. The buffer is only valid between the swap and the
+// next Domain::Update(), so it never needs to be reordered.
 struct BaseParticlesState {
-  std::vector<Vectord> pos;
-  std::vector<Vectord> vel;
-  std::vector<double> dty;
-
-  void Set(const Particles& p) {
-    pos = p.pos();
-    vel = p.vel();
-    dty = p.dty();
+  GpuVector<Vectord> pos;
+  VelocityVector vel;
+  GpuVector<double> dty;
+
+  void Resize(const size_t n) {
+    pos.resize(n);
+    vel.resize(n);
+    dty.resize(n);
   }
+
+  void Swap(Particles& p) { p.SwapState(pos, vel, dty); }
 };
 
 class ForwardEuler {
@@ -59,14 +65,24 @@ class ForwardEuler {
 class DualSPHysicsVerletTS {
  public:
   DualSPHysicsVerletTS() = default;
-  DualSPHysicsVerletTS(const Vectord gravity) : gravity_(gravity) {}
+  // With fused_shifting the shifting terms are computed in the RHS sweep of
+  // the corrector stage from its state, as in DualSPHysics, instead of in a
+  // separate traversal of the neighbors after the step. This also saves the
+  // Domain::Update between the corrector and the shifting.
+  DualSPHysicsVerletTS(const Vectord gravity, const bool fused_shifting = false)
+      : gravity_(gravity), fused_shifting_(fused_shifting) {}
 
   void TimeStep(const double dt, Domain& d);
 
- private:
+  // The integration stages of TimeStep with the last computed derivative.
+  // The final step reads the state of the step start, which the predictor
+  // swapped into the second buffer.
+  void IntegratePredictorStep(const double dt, Domain& d);
   void IntegrateFinalStep(const double dt, Domain& d);
 
+ private:
   Vectord gravity_;
+  bool fused_shifting_ = false;
   BasicWeaklyRhs rhs_ = BasicWeaklyRhs(1.5);
   BaseParticlesState init_state_;
   Derivative derivative_;
@@ -0,0 +1,109 @@
+#include "container/pointer_ensured_vector.hpp"
+
+#include <gtest/gtest.h>
+#include <omp.h>
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+struct CountedRecord {
+  static inline std::atomic<int64_t> num_live = 0;
+
+  explicit CountedRecord(const int64_t v = -1) : value(v) { ++num_live; }
+  ~CountedRecord() { --num_live; }
+
+  int64_t value;
+};
+
+TEST(PointerEnsuredVector, StablePointers) {
+  PointerEnsuredVector<CountedRecord> pool(5);
+  std::vector<CountedRecord*> records;
+  for (int64_t i = 0; i < 23; ++i) {
+    records.push_back(pool.GetNewData(i));
+  }
+  EXPECT_EQ(pool.size(), 23);
+  EXPECT_EQ(pool.capacity(), 25);
+  for (int64_t i = 0; i < 23; ++i) {
+    EXPECT_EQ(records[i]->value, i);
+  }
+  // freed slots are reused before the pool grows
+  pool.Free(records[3]);
+  EXPECT_EQ(CountedRecord::num_live, 22);
+  EXPECT_EQ(pool.GetNewData(100), records[3]);
+  EXPECT_EQ(pool.capacity(), 25);
+  EXPECT_EQ(records[3]->value, 100);
+}
+
+TEST(PointerEnsuredVector, Bulk) {
+  {
+    PointerEnsuredVector<CountedRecord> pool(16);
+    std::vector<CountedRecord*> first = pool.GetNewDataBulk(10, 1);
+    pool.Free(first[4]);
+    pool.Free(first[7]);
+    const std::vector<CountedRecord*> bulk = pool.GetNewDataBulk(100, 2);
+    ASSERT_EQ(bulk.size(), 100);
+    EXPECT_EQ(pool.size(), 108);
+    // 2 freed slots, 6 of the first chunk and 6 new chunks
+    EXPECT_EQ(pool.capacity(), 7 * 16);
+    for (const CountedRecord* r : bulk) {
+      EXPECT_EQ(r->value, 2);
+    }
+    EXPECT_EQ(CountedRecord::num_live, 108);
+  }
+  // the destructor destroys the live objects
+  EXPECT_EQ(CountedRecord::num_live, 0);
+}
+
+TEST(PointerEnsuredVector, AlternatingPools) {
+  PointerEnsuredVector<CountedRecord> a(4), b(4);
+  std::vector<CountedRecord*> from_a, from_b;
+  for (int64_t i = 0; i < 10; ++i) {
+    from_a.push_back(a.GetNewData(i));
+    from_b.push_back(b.GetNewData(-i));
+  }
+  // every pool reuses only its own freed slots
+  a.Free(from_a[2]);
+  b.Free(from_b[5]);
+  EXPECT_EQ(b.GetNewData(50), from_b[5]);
+  EXPECT_EQ(a.GetNewData(20), from_a[2]);
+  EXPECT_EQ(a.size(), 10);
+  EXPECT_EQ(b.size(), 10);
+  EXPECT_EQ(a.capacity(), 12);
+  EXPECT_EQ(b.capacity(), 12);
+}
+
+TEST(PointerEnsuredVector, Concurrent) {
+  constexpr int64_t per_thread = 10000;
+  PointerEnsuredVector<CountedRecord> pool(32);
+  int num_threads = 0;
+#pragma omp parallel
+  {
+#pragma omp single
+    num_threads = omp_get_num_threads();
+    const int64_t tid = omp_get_thread_num();
+    std::vector<CountedRecord*> mine;
+    for (int64_t i = 0; i < per_thread; ++i) {
+      mine.push_back(pool.GetNewData(tid * per_thread + i));
+    }
+    for (int64_t i = 1; i < per_thread; i += 2) {
+      pool.Free(mine[i]);
+    }
+  }
+  EXPECT_EQ(pool.size(), num_threads * per_thread / 2);
+  EXPECT_EQ(CountedRecord::num_live, num_threads * per_thread / 2);
+
+  std::vector<std::atomic<int>> found(num_threads * per_thread);
+  pool.ForEach([&found](CountedRecord& r) { ++found[r.value]; });
+  for (size_t i = 0; i < found.size(); ++i) {
+    ASSERT_EQ(found[i], i % 2 == 0 ? 1 : 0) << "at " << i;
+  }
+  std::atomic<int64_t> sum = 0;
+  const auto& const_pool = pool;
+  const_pool.ForEach([&sum](const CountedRecord& r) { sum += r.value; });
+  int64_t ref = 0;
+  for (int64_t i = 0; i < num_threads * per_thread; i += 2) {
+    ref += i;
+  }
+  EXPECT_EQ(sum, ref);
+}
@@ -0,0 +1,67 @@
+#include "container/soa_vector.hpp"
+
+#include <gtest/gtest.h>
+
+#include "utils/types.hpp"
+
+using SoaVectord = SoaVector<double, 3>;
+
+TEST(SoaVector, Components) {
+  SoaVectord v(5, Vectord(1., 2., 3.));
+  ASSERT_EQ(v.size(), 5);
+  v[3] = Vectord(4., 5., 6.);
+  for (size_t c = 0; c < 3; ++c) {
+    EXPECT_EQ(v.data(c)[3], 4. + c);
+    EXPECT_EQ(v.component(c)[0], 1. + c);
+  }
+  v.data(1)[2] = 7.;
+  EXPECT_EQ(v[2][1], 7.);
+  v.resize(8);
+  EXPECT_EQ(v.size(), 8);
+  EXPECT_EQ(v.component(2).size(), 8);
+  SoaVectord w;
+  v.swap(w);
+  EXPECT_TRUE(v.empty());
+  EXPECT_EQ(w.size(), 8);
+}
+
+// the source of the particle loops compiles for both layouts
+template <typename Vectors>
+void UpdateLoop(const double dt, const Vectord gravity, Vectors& vel,
+                Vectors& pos) {
+  for (size_t i = 0; i < vel.size(); ++i) {
+    vel[i] += dt * gravity;
+    pos[i] = pos[i] + dt * vel[i];
+    const Vectord& p = pos[i];
+    pos[i][2] -= 0.5 * dt * (vel[i] * vel[i]) + p[0];
+  }
+}
+
+TEST(SoaVector, ReferenceMatchesArray) {
+  const size_t n = 17;
+  GpuVector<Vectord> aos_vel(n), aos_pos(n);
+  SoaVectord soa_vel(n), soa_pos(n);
+  for (size_t i = 0; i < n; ++i) {
+    aos_vel[i] = Vectord(i, -0.5 * i, 1.);
+    aos_pos[i] = Vectord(0.1 * i, 2., -3. * i);
+    soa_vel[i] = aos_vel[i];
+    soa_pos[i] = aos_pos[i];
+  }
+  UpdateLoop(0.01, Vectord(0., 0., -9.81), aos_vel, aos_pos);
+  UpdateLoop(0.01, Vectord(0., 0., -9.81), soa_vel, soa_pos);
+  const SoaVectord& const_pos = soa_pos;
+  for (size_t i = 0; i < n; ++i) {
+    const Vectord vel = soa_vel[i], pos = const_pos[i];
+    for (size_t c = 0; c < 3; ++c) {
+      ASSERT_EQ(vel[c], aos_vel[i][c]) << "at " << i;
+      ASSERT_EQ(pos[c], aos_pos[i][c]) << "at " << i;
+    }
+  }
+  // the assignment of a reference copies the value
+  soa_vel[0] = soa_vel[1];
+  soa_vel[1] *= 2.;
+  EXPECT_EQ(soa_vel[0][0], aos_vel[1][0]);
+  EXPECT_EQ(soa_vel[1][0], 2. * aos_vel[1][0]);
+  const Vectord diff = soa_vel[1] - soa_vel[0] + (-soa_vel[0]) / 2.;
+  EXPECT_DOUBLE_EQ(diff[0], 0.5 * aos_vel[1][0]);
+}
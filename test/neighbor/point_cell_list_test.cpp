@@ -2,6 +2,8 @@
 
 #include <gtest/gtest.h>
 
+#include "neighbor/field_gather.hpp"
+
 std::vector<Vectord> TestPoints(const double dr = 0.1) {
   const Vectord off(-dr * 4.), d1(1.e-10, -1.e-10, dr), d2(-1.e-10, dr, 1.e-10);
   std::vector<Vectord> res;
@@ -44,4 +46,52 @@ TEST(PointCellList, Create) {
     ASSERT_EQ(c1[1], c2[1]);
     ASSERT_EQ(c1[2], c2[2]);
   }
-}
\ No newline at end of file
+}
+TEST(PointCellList, FieldGather) {
+  const double dr = 0.1;
+  const std::vector<Vectord> points = TestPoints(dr);
+  auto [idx_map, point_cells] = PointCellListD::Create(dr, points);
+  GpuVector<Vectord> pos = points;
+  GpuVector<double> idx(points.size());
+  GpuVector<uint8_t> flag(points.size());
+  for (size_t i = 0; i < points.size(); ++i) {
+    idx[i] = i;
+    flag[i] = i % 3;
+  }
+  FieldGather gather;
+  gather(idx_map, pos, idx, flag);
+  for (size_t i = 0; i < points.size(); ++i) {
+    ASSERT_EQ(pos[i][0], point_cells[i][0]);
+    ASSERT_EQ(pos[i][2], point_cells[i][2]);
+    ASSERT_EQ(idx[i], idx_map[i]);
+    ASSERT_EQ(flag[i], idx_map[i] % 3);
+  }
+  // the old fields are the buffers of the next gather
+  const double* first = idx.data();
+  gather(idx_map, std::tie(pos, idx, flag));
+  gather(idx_map, std::tie(pos, idx, flag));
+  EXPECT_EQ(idx.data(), first);
+}
+
+TEST(PointCellList, UpdateInPlace) {
+  const double dr = 0.1;
+  std::vector<Vectord> points = TestPoints(dr);
+  auto [idx_map, gathered] = PointCellListD::Create(dr, points);
+  // moves the points across cells
+  for (SizeT i = 0; i < gathered.size(); ++i) {
+    gathered[i] = gathered[i] + Vectord((i % 7) * dr, -(i % 5) * dr, 0.);
+  }
+  PointCellListD permuted = gathered;
+  const ScratchVector<SizeT> gather_map = gathered.Update();
+  SetPermutePolicy(PermutePolicy::kInPlace);
+  const ScratchVector<SizeT> permute_map = permuted.Update();
+  SetPermutePolicy(PermutePolicy::kGather);
+  ASSERT_EQ(gather_map.size(), permute_map.size());
+  EXPECT_EQ(gathered.num_cells(), permuted.num_cells());
+  for (SizeT i = 0; i < gathered.size(); ++i) {
+    ASSERT_EQ(gather_map[i], permute_map[i]);
+    ASSERT_EQ(gathered[i][0], permuted[i][0]);
+    ASSERT_EQ(gathered[i][1], permuted[i][1]);
+    ASSERT_EQ(gathered[i][2], permuted[i][2]);
+  }
+}
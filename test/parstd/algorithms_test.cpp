@@ -0,0 +1,224 @@
+#include "parstd/parstd.hpp"
+
+#include <gtest/gtest.h>
+#include <omp.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <random>
+#include <tuple>
+
+#include "algo/morton.hpp"
+#include "parstd/par_sort_own.hpp"
+#include "utils/random.hpp"
+
+// large enough to use all threads in the parallel backends
+constexpr size_t num_test_elements = 1 << 20;
+
+TEST(ParStd, Sort) {
+  GpuVector<uint64_t> v = Random<uint64_t>(num_test_elements, 0, 1 << 30);
+  std::vector<uint64_t> ref(v.begin(), v.end());
+  Sort(v);
+  std::sort(ref.begin(), ref.end());
+  ASSERT_EQ(v.size(), ref.size());
+  for (size_t i = 0; i < v.size(); ++i) {
+    ASSERT_EQ(v[i], ref[i]) << "at " << i;
+  }
+}
+
+TEST(ParStd, SortComp) {
+  GpuVector<int32_t> v = Random<int32_t>(num_test_elements + 13, -1000, 1000);
+  Sort(v, [](const int32_t a, const int32_t b) { return a > b; });
+  EXPECT_TRUE(std::is_sorted(v.begin(), v.end(), std::greater<>()));
+}
+
+TEST(ParStd, SortMortIdx) {
+  const auto keys = Random<uint64_t>(num_test_elements, 0, 1000);
+  GpuVector<MortIdx<Morton64>> v(keys.size());
+  for (size_t i = 0; i < v.size(); ++i) {
+    v[i] = {Morton64(keys[i]), static_cast<uint32_t>(i)};
+  }
+  Sort(v);
+  std::vector<bool> found(v.size(), false);
+  for (size_t i = 0; i < v.size(); ++i) {
+    if (i > 0) {
+      ASSERT_FALSE(v[i] < v[i - 1]) << "at " << i;
+    }
+    ASSERT_EQ(v[i].morton.value(), keys[v[i].idx]);
+    found[v[i].idx] = true;
+  }
+  EXPECT_TRUE(
+      std::all_of(found.begin(), found.end(), [](bool b) { return b; }));
+}
+
+TEST(ParStd, RadixSortSigned) {
+  GpuVector<int64_t> v = Random<int64_t>(num_test_elements, -(1l << 40), 1000);
+  std::vector<int64_t> ref(v.begin(), v.end());
+  RadixSort(v);
+  std::sort(ref.begin(), ref.end());
+  EXPECT_TRUE(std::equal(v.begin(), v.end(), ref.begin()));
+}
+
+TEST(ParStd, RadixSortStable) {
+  const auto keys = Random<uint64_t>(num_test_elements, 1 << 20, 1 << 21);
+  GpuVector<MortIdx<Morton64>> v(keys.size());
+  for (size_t i = 0; i < v.size(); ++i) {
+    v[i] = {Morton64(keys[i]), static_cast<uint32_t>(i)};
+  }
+  RadixSort(v);
+  for (size_t i = 1; i < v.size(); ++i) {
+    ASSERT_LE(v[i - 1].morton.value(), v[i].morton.value()) << "at " << i;
+    if (v[i - 1].morton == v[i].morton) {
+      ASSERT_LT(v[i - 1].idx, v[i].idx) << "at " << i;
+    }
+  }
+}
+
+TEST(ParStd, SortParallelSample) {
+  const auto keys = Random<uint64_t>(num_test_elements + 7, 0, 1000);
+  std::vector<MortIdx<Morton64>> v(keys.size());
+  for (size_t i = 0; i < v.size(); ++i) {
+    v[i] = {Morton64(keys[i]), static_cast<uint32_t>(i)};
+  }
+  // descending, the comparator is the only operation used on the values
+  SortParallelSample(v, [](const auto& a, const auto& b) { return b < a; });
+  std::vector<bool> found(v.size(), false);
+  for (size_t i = 0; i < v.size(); ++i) {
+    if (i > 0) {
+      ASSERT_FALSE(v[i - 1] < v[i]) << "at " << i;
+    }
+    ASSERT_EQ(v[i].morton.value(), keys[v[i].idx]);
+    found[v[i].idx] = true;
+  }
+  EXPECT_TRUE(
+      std::all_of(found.begin(), found.end(), [](bool b) { return b; }));
+}
+
+TEST(ParStd, SortParallelSampleReusedScratch) {
+  GpuVector<uint64_t> scratch;
+  for (const size_t n : {num_test_elements, num_test_elements / 3}) {
+    std::vector<uint64_t> v = Random<uint64_t>(n, 0, 1 << 30), ref = v;
+    SortParallelSample(v, scratch);
+    std::sort(ref.begin(), ref.end());
+    ASSERT_EQ(v, ref);
+  }
+}
+
+TEST(ParStd, MergeParallel) {
+  // b lies entirely before most of a, so splitting along a would be unbalanced
+  std::vector<uint32_t> a = Random<uint32_t>(num_test_elements, 0, 1 << 20),
+                        b = Random<uint32_t>(num_test_elements / 2, 0, 1 << 10);
+  std::sort(a.begin(), a.end());
+  std::sort(b.begin(), b.end());
+  std::vector<uint32_t> ref(a.size() + b.size()), res(ref.size());
+  std::merge(a.begin(), a.end(), b.begin(), b.end(), ref.begin());
+  MergeParallel(a, b, res);
+  EXPECT_TRUE(std::equal(res.begin(), res.end(), ref.begin()));
+  MergeParallel(b, std::vector<uint32_t>(), res);
+  EXPECT_TRUE(std::equal(b.begin(), b.end(), res.begin()));
+}
+
+TEST(ParStd, Unique) {
+  GpuVector<uint32_t> v = Random<uint32_t>(num_test_elements, 0, 5000);
+  std::sort(v.begin(), v.end());
+  std::vector<uint32_t> ref(v.begin(), v.end());
+  ref.erase(std::unique(ref.begin(), ref.end()), ref.end());
+  Unique(v);
+  ASSERT_EQ(v.size(), ref.size());
+  EXPECT_TRUE(std::equal(v.begin(), v.end(), ref.begin()));
+}
+
+TEST(ParStd, Reduce) {
+  const GpuVector<int64_t> v = Random<int64_t>(num_test_elements, -100, 100);
+  EXPECT_EQ(Reduce(v), std::accumulate(v.begin(), v.end(), int64_t{0}));
+  EXPECT_EQ(Reduce(v, int64_t{7}),
+            std::accumulate(v.begin(), v.end(), int64_t{7}));
+  EXPECT_EQ(Reduce(v, int64_t{-1000},
+                   [](const int64_t a, const int64_t b) {
+                     return std::max(a, b);
+                   }),
+            *std::max_element(v.begin(), v.end()));
+  EXPECT_EQ(TransformReduce(v, int64_t{0}, std::plus<>(),
+                            [](const int64_t a) { return a * a; }),
+            std::transform_reduce(v.begin(), v.end(), int64_t{0},
+                                  std::plus<>(),
+                                  [](const int64_t a) { return a * a; }));
+}
+
+TEST(ParStd, TransformReduceIndex) {
+  const GpuVector<int64_t> v = Random<int64_t>(num_test_elements, -100, 100);
+  int64_t ref = 3;
+  for (size_t i = 0; i < v.size(); ++i) {
+    ref += v[i] * int64_t(i);
+  }
+  EXPECT_EQ(TransformReduce(
+                v.size(), int64_t{3}, std::plus<>(),
+                [&v](const size_t i) { return v[i] * int64_t(i); }),
+            ref);
+  EXPECT_EQ(
+      TransformReduce(0, 5, std::plus<>(), [](const size_t) { return 1; }), 5);
+}
+
+TEST(ParStd, TransformReduceTuple) {
+  const GpuVector<int64_t> a = Random<int64_t>(num_test_elements, -100, 100);
+  const GpuVector<double> b = Random<double>(num_test_elements, -1., 1.);
+  const auto [min_a, max_b, sum_a] = TransformReduce(
+      a.size(), std::tuple(int64_t{1000}, -2., int64_t{0}),
+      std::tuple(MinOp(), MaxOp(), std::plus<>()),
+      [&](const size_t i) { return std::tuple(a[i], b[i], a[i]); });
+  EXPECT_EQ(min_a, *std::min_element(a.begin(), a.end()));
+  EXPECT_EQ(max_b, *std::max_element(b.begin(), b.end()));
+  EXPECT_EQ(sum_a, std::accumulate(a.begin(), a.end(), int64_t{0}));
+}
+
+TEST(ParStd, ExclusiveScan) {
+  const GpuVector<uint32_t> v =
+      Random<uint32_t>(num_test_elements + 3, 0, 10);
+  std::vector<uint32_t> ref(v.size());
+  std::exclusive_scan(v.begin(), v.end(), ref.begin(), 5u);
+  GpuVector<uint32_t> res(v.size());
+  ExclusiveScan(v, res, 5u);
+  EXPECT_TRUE(std::equal(res.begin(), res.end(), ref.begin()));
+}
+
+TEST(ParStd, Merge) {
+  GpuVector<uint32_t> a = Random<uint32_t>(num_test_elements, 0, 1 << 20),
+                      b = Random<uint32_t>(num_test_elements / 3, 0, 1 << 10);
+  std::sort(a.begin(), a.end());
+  std::sort(b.begin(), b.end());
+  std::vector<uint32_t> ref(a.size() + b.size());
+  std::merge(a.begin(), a.end(), b.begin(), b.end(), ref.begin());
+  const GpuVector<uint32_t> res = Merge(a, b);
+  ASSERT_EQ(res.size(), ref.size());
+  EXPECT_TRUE(std::equal(res.begin(), res.end(), ref.begin()));
+}
+
+TEST(ParStd, PermuteInPlace) {
+  const size_t n = num_test_elements + 5;
+  std::vector<SizeT> shuffled(n), rotated(n), identity(n);
+  std::iota(identity.begin(), identity.end(), 0);
+  shuffled = identity;
+  std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937(7));
+  // a single cycle through all elements
+  for (size_t i = 0; i < n; ++i) {
+    rotated[i] = (i + 1) % n;
+  }
+  const GpuVector<double> values = Random<double>(n, -1., 1.);
+  const int max_threads = omp_get_max_threads();
+  for (const int nt : {1, 3, max_threads}) {
+    omp_set_num_threads(nt);
+    for (const auto* idx_map : {&shuffled, &rotated, &identity}) {
+      GpuVector<double> v = values;
+      GpuVector<uint32_t> ids(identity.begin(), identity.end());
+      PermuteInPlace(*idx_map, v, ids);
+      for (size_t i = 0; i < n; ++i) {
+        ASSERT_EQ(ids[i], (*idx_map)[i]) << "at " << i << " threads " << nt;
+        ASSERT_EQ(v[i], values[(*idx_map)[i]]) << "at " << i;
+      }
+    }
+  }
+  omp_set_num_threads(max_threads);
+  std::vector<SizeT> empty;
+  PermuteInPlace(empty);
+}
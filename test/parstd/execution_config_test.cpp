@@ -0,0 +1,49 @@
+#include "parstd/execution_config.hpp"
+
+#include <gtest/gtest.h>
+#include <omp.h>
+
+#include <vector>
+
+// two sockets with two cores of two hardware threads each, numbered like linux
+// does: the first siblings of all cores before the second ones
+static std::vector<CpuInfo> TwoSocketCpus() {
+  return {{0, 0, 0}, {1, 0, 1}, {2, 1, 0}, {3, 1, 1},
+          {4, 0, 0}, {5, 0, 1}, {6, 1, 0}, {7, 1, 1}};
+}
+
+TEST(ExecutionConfig, PinnedCpusCompact) {
+  EXPECT_EQ(PinnedCpus(TwoSocketCpus(), PinPolicy::kCompact, true),
+            std::vector<int>({0, 4, 1, 5, 2, 6, 3, 7}));
+  EXPECT_EQ(PinnedCpus(TwoSocketCpus(), PinPolicy::kCompact, false),
+            std::vector<int>({0, 1, 2, 3}));
+}
+
+TEST(ExecutionConfig, PinnedCpusScatter) {
+  EXPECT_EQ(PinnedCpus(TwoSocketCpus(), PinPolicy::kScatter, true),
+            std::vector<int>({0, 2, 1, 3, 4, 6, 5, 7}));
+  EXPECT_EQ(PinnedCpus(TwoSocketCpus(), PinPolicy::kScatter, false),
+            std::vector<int>({0, 2, 1, 3}));
+}
+
+TEST(ExecutionConfig, PinnedCpusOnePerCore) {
+  EXPECT_EQ(PinnedCpus(TwoSocketCpus(), PinPolicy::kOnePerCore, true),
+            std::vector<int>({0, 1, 2, 3}));
+  EXPECT_TRUE(PinnedCpus(TwoSocketCpus(), PinPolicy::kNone, true).empty());
+}
+
+TEST(ExecutionConfig, Apply) {
+  const int prev_threads = omp_get_max_threads();
+  ApplyExecutionConfig({3, PinPolicy::kNone, true});
+  EXPECT_EQ(omp_get_max_threads(), 3);
+  EXPECT_FALSE(ExecutionReport().empty());
+  ApplyExecutionConfig({prev_threads, PinPolicy::kNone, true});
+}
+
+TEST(ExecutionConfig, DefaultKeepsThreadCount) {
+  const int prev_threads = omp_get_max_threads();
+  omp_set_num_threads(3);
+  ApplyExecutionConfig(ExecutionConfig());
+  EXPECT_EQ(omp_get_max_threads(), 3);
+  omp_set_num_threads(prev_threads);
+}
@@ -0,0 +1,61 @@
+#include "parstd/parallel_for.hpp"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cmath>
+#include <vector>
+
+class ParallelForTest : public ::testing::TestWithParam<Schedule> {
+ protected:
+  void SetUp() override {
+    prev_ = GetParallelForSchedule();
+    SetParallelForSchedule(GetParam());
+  }
+  void TearDown() override { SetParallelForSchedule(prev_); }
+
+ private:
+  Schedule prev_;
+};
+
+TEST_P(ParallelForTest, VisitsEachIndexOnce) {
+  const size_t b = 17, e = 100'003;
+  std::vector<std::atomic<int>> visits(e);
+  ParallelForStats stats;
+  // skewed work, so the work stealing scheduler has to steal
+  ParallelFor(
+      IndexRange<size_t>(b, e), 7,
+      [&](const size_t i) {
+        double acc = 0.;
+        for (size_t k = 0; k < ((i > e - 1000) ? 10000 : 1); ++k) {
+          acc += std::sqrt(k);
+        }
+        visits[i] += (acc >= 0.) ? 1 : 2;
+      },
+      &stats);
+  for (size_t i = 0; i < e; ++i) {
+    ASSERT_EQ(visits[i], (i < b) ? 0 : 1) << "at " << i;
+  }
+  size_t work = 0;
+  for (const size_t w : stats.work) work += w;
+  EXPECT_EQ(work, e - b);
+  EXPECT_EQ(stats.busy.size(), stats.num_threads());
+  EXPECT_GE(stats.Imbalance(), 1.);
+  if (GetParam() != Schedule::kWorkStealing) {
+    EXPECT_EQ(stats.TotalSteals(), 0);
+  }
+}
+
+TEST_P(ParallelForTest, EmptyRange) {
+  ParallelForStats stats;
+  size_t calls = 0;
+  ParallelFor(IndexRange<size_t>(5, 5), 1, [&](const size_t) { ++calls; },
+              &stats);
+  EXPECT_EQ(calls, 0);
+  EXPECT_EQ(stats.TotalSteals(), 0);
+}
+
+INSTANTIATE_TEST_SUITE_P(Schedules, ParallelForTest,
+                         ::testing::Values(Schedule::kWorkStealing,
+                                           Schedule::kGuided,
+                                           Schedule::kDynamic));
@@ -0,0 +1,77 @@
+#include "parstd/step_arena.hpp"
+
+#include <gtest/gtest.h>
+#include <omp.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <vector>
+
+#include "parstd/parstd.hpp"
+#include "utils/random.hpp"
+
+TEST(StepArena, AllocateAligned) {
+  StepArena arena(1 << 12);
+  char* a = static_cast<char*>(arena.Allocate(3, 1));
+  char* b = static_cast<char*>(arena.Allocate(16, 64));
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(b) % 64, 0);
+  EXPECT_GE(b, a + 3);
+  // larger than a chunk
+  void* c = arena.Allocate(1 << 14, 8);
+  EXPECT_NE(c, nullptr);
+  EXPECT_GE(arena.BytesInUse(), 3 + 16 + (1 << 14));
+}
+
+TEST(StepArena, ResetRewinds) {
+  StepArena arena(1 << 12);
+  arena.Allocate(128, 8);
+  arena.Allocate(1 << 13, 8);
+  const size_t in_use = arena.BytesInUse();
+  arena.Reset();
+  EXPECT_EQ(arena.BytesInUse(), 0);
+  EXPECT_EQ(arena.HighWaterMark(), in_use);
+  // the overflowed chunks are merged, so the next step fits into one chunk
+  void* start = arena.Allocate(128, 8);
+  const size_t reserved = arena.ReservedBytes();
+  EXPECT_GE(reserved, in_use);
+  arena.Allocate(1 << 13, 8);
+  EXPECT_EQ(arena.ReservedBytes(), reserved);
+  arena.Reset();
+  EXPECT_EQ(arena.Allocate(128, 8), start);
+}
+
+TEST(StepArena, ThreadsDoNotOverlap) {
+  StepArena arena(1 << 12);
+  constexpr size_t n = 1000, bytes = 24;
+  std::vector<uint8_t*> ptrs(n);
+#pragma omp parallel for schedule(dynamic)
+  for (size_t i = 0; i < n; ++i) {
+    ptrs[i] = static_cast<uint8_t*>(arena.Allocate(bytes, 8));
+    std::fill(ptrs[i], ptrs[i] + bytes, static_cast<uint8_t>(i));
+  }
+  for (size_t i = 0; i < n; ++i) {
+    for (size_t b = 0; b < bytes; ++b) {
+      ASSERT_EQ(ptrs[i][b], static_cast<uint8_t>(i)) << "at " << i;
+    }
+  }
+  std::sort(ptrs.begin(), ptrs.end());
+  for (size_t i = 1; i < n; ++i) {
+    ASSERT_GE(ptrs[i], ptrs[i - 1] + bytes);
+  }
+}
+
+TEST(StepArena, ScratchVector) {
+  const std::vector<uint64_t> keys = Random<uint64_t>(1 << 16, 0, 1 << 30);
+  ScratchVector<uint64_t> v(keys.begin(), keys.end());
+  v.push_back(7);
+  Sort(v);
+  EXPECT_TRUE(std::is_sorted(v.begin(), v.end()));
+  Unique(v);
+  EXPECT_TRUE(std::adjacent_find(v.begin(), v.end()) == v.end());
+  const GpuVector<uint64_t> copy = v;
+  EXPECT_TRUE(std::equal(copy.begin(), copy.end(), v.begin()));
+  v = ScratchVector<uint64_t>();
+  GetStepArena().Reset();
+  EXPECT_GT(GetStepArena().HighWaterMark(), keys.size() * sizeof(uint64_t));
+}
@@ -5,6 +5,8 @@
 #include <atomic>
 #include <cstdint>
 
+#include "utils/types.hpp"
+
 struct NeedInit {
   static std::atomic<int> num_init;
 
@@ -172,3 +174,65 @@ TEST(Vector, Erase) {
   EXPECT_EQ(v[0].val, 1);
   EXPECT_EQ(v[1].val, 3);
 }
+
+TEST(Vector, NumaPolicies) {
+  const NumaPolicy prev = GetNumaPolicy();
+  // large enough to be mapped by the NumaAllocator
+  constexpr size_t n = 1 << 20;
+  for (const NumaPolicy policy :
+       {NumaPolicy::kNone, NumaPolicy::kFirstTouch, NumaPolicy::kInterleave}) {
+    SetNumaPolicy(policy);
+    GpuVector<uint64_t> v(n, 7);
+    v.push_back(8);
+    EXPECT_EQ(v[0], 7);
+    EXPECT_EQ(v[n - 1], 7);
+    EXPECT_EQ(v[n], 8);
+    const std::vector<size_t> pages =
+        NumaPagesPerNode(v.data(), v.size() * sizeof(uint64_t));
+    if (!pages.empty()) {
+      size_t num_pages = 0;
+      for (const size_t p : pages) num_pages += p;
+      EXPECT_GE(num_pages, n * sizeof(uint64_t) / 4096);
+    }
+  }
+  SetNumaPolicy(prev);
+}
+
+TEST(Vector, HugePageAllocation) {
+  const bool prev = GetHugePages();
+  // a padded mapping and an exact multiple of the huge page size
+  for (const size_t n : {(size_t(5) << 20) / sizeof(double) + 3,
+                         (size_t(4) << 20) / sizeof(double)}) {
+    for (const bool huge_pages : {false, true}) {
+      SetHugePages(huge_pages);
+      GpuVector<double> v;
+      v.resize(n);
+      // the mapping is aligned, the data starts at a colour offset into it
+      EXPECT_LT(reinterpret_cast<uintptr_t>(v.data()) % (size_t(2) << 20),
+                4096);
+      for (size_t i = 0; i < v.size(); ++i) {
+        v[i] = i;
+      }
+      v.resize(2 * n);
+      EXPECT_EQ(v[n - 1], n - 1);
+    }
+  }
+  SetHugePages(prev);
+}
+
+TEST(Vector, StaggeredLargeAllocations) {
+  // fields of the same size do not all start at the same offset modulo 4kB
+  constexpr size_t n = (size_t(2) << 20) / sizeof(double);
+  const GpuVector<double> a(n), b(n);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(a.data()) % alignof(double), 0);
+  EXPECT_NE(reinterpret_cast<uintptr_t>(a.data()) % 4096,
+            reinterpret_cast<uintptr_t>(b.data()) % 4096);
+}
+
+TEST(Vector, ResizeKeepsValues) {
+  GpuVector<Vectord> v(3, Vectord(1.));
+  v.resize(5);
+  EXPECT_EQ(v[2][1], 1.);
+  v.resize(7, Vectord(2.));
+  EXPECT_EQ(v[6][2], 2.);
+}
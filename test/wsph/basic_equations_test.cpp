@@ -2,7 +2,10 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <type_traits>
 
 #include "utils/types.hpp"
 
@@ -71,3 +74,91 @@ TEST(BasicEquations, KernelGradientHalf) {
   EXPECT_NEAR(grad[1], 0., 1.e-3);
   EXPECT_NEAR(grad[2], 0., 1.e-3);
 }
+
+TEST(BasicEquations, KernelPolicies) {
+  const double h = 0.15;
+  const WendlandPolicy wendland(h);
+  const CubicSplinePolicy cubic(h);
+  const QuadraticSplinePolicy quadratic(h);
+  const ChiPolicy<QuadraticSplinePolicy> chi(0.1);
+  for (double dist = 0.; dist < 2. * h; dist += 0.01 * h) {
+    EXPECT_DOUBLE_EQ(wendland.W(dist), Wendland(dist, h));
+    EXPECT_DOUBLE_EQ(wendland.Gradient(dist), WendlandGradient(dist, h));
+    EXPECT_DOUBLE_EQ(cubic.W(dist), CubicSplineKernel(dist, h));
+    EXPECT_DOUBLE_EQ(cubic.Gradient(dist),
+                     CubicSplineKernelDerivative(dist, h));
+    EXPECT_DOUBLE_EQ(quadratic.W(dist), Kernel(dist, h));
+    EXPECT_DOUBLE_EQ(quadratic.Gradient(dist), KernelGradient(dist, h));
+    if (dist < 0.1) {
+      EXPECT_DOUBLE_EQ(chi(dist), Chi(dist, 0.1));
+    }
+  }
+  EXPECT_DOUBLE_EQ(
+      DispatchKernel(KernelType::kWendland, h,
+                     [](const auto& kernel) { return kernel.W(0.1); }),
+      Wendland(0.1, h));
+  EXPECT_DOUBLE_EQ(
+      DispatchKernel(KernelType::kCubicSpline, h,
+                     [](const auto& kernel) { return kernel.W(0.1); }),
+      CubicSplineKernel(0.1, h));
+}
+
+// the largest error of tabulated against analytic over the distances of
+// q in [0.3, 2.4], relative to the largest magnitude of analytic
+template <typename Tabulated, typename Analytic>
+double MaxTableError(const double h, Tabulated&& tabulated,
+                     Analytic&& analytic) {
+  double max_error = 0., max_value = 0.;
+  for (double q = 0.3; q < 2.4; q += 0.001) {
+    const double dist = q * h;
+    max_error =
+        std::max(max_error, std::abs(tabulated(dist) - analytic(dist)));
+    max_value = std::max(max_value, std::abs(analytic(dist)));
+  }
+  return max_error / max_value;
+}
+
+TEST(BasicEquations, TabulatedKernel) {
+  const double h = 0.15, dr = 0.1;
+  for (const KernelType type :
+       {KernelType::kWendland, KernelType::kCubicSpline,
+        KernelType::kQuadraticSpline}) {
+    DispatchKernel(type, h, [&](const auto& kernel) {
+      using Kernel = std::decay_t<decltype(kernel)>;
+      const TabulatedPolicy<Kernel> tabulated(h);
+      EXPECT_LT(MaxTableError(
+                    h, [&](double d) { return tabulated.WOfDist2(d * d); },
+                    [&](double d) { return kernel.W(d); }),
+                1.e-5);
+      EXPECT_LT(MaxTableError(
+                    h,
+                    [&](double d) { return tabulated.GradientOverDist(d * d); },
+                    [&](double d) { return kernel.Gradient(d) / d; }),
+                1.e-5);
+      EXPECT_LT(MaxTableError(
+                    h, [&](double d) { return tabulated.Gradient(d); },
+                    [&](double d) { return kernel.Gradient(d); }),
+                1.e-5);
+      // Chi is used below dr
+      const ChiPolicy<Kernel> chi(dr);
+      const ChiPolicy<TabulatedPolicy<Kernel>> tabulated_chi(dr);
+      for (double dist = 0.3 * dr; dist < dr; dist += 0.001 * dr) {
+        ASSERT_NEAR(tabulated_chi.OfDist2(dist * dist), chi(dist), 1.e-5);
+        ASSERT_NEAR(tabulated_chi(dist), chi(dist), 1.e-5);
+      }
+      // the squared distance overloads of the analytic policies
+      EXPECT_DOUBLE_EQ(kernel.WOfDist2(0.01), kernel.W(0.1));
+      EXPECT_DOUBLE_EQ(kernel.GradientOverDist(0.01),
+                       kernel.Gradient(0.1) / 0.1);
+      EXPECT_DOUBLE_EQ(chi.OfDist2(0.0025), chi(0.05));
+    });
+  }
+  EXPECT_DOUBLE_EQ(
+      DispatchKernel(KernelType::kCubicSpline, true, h,
+                     [](const auto& kernel) { return kernel.W(0.1); }),
+      TabulatedPolicy<CubicSplinePolicy>(h).W(0.1));
+  EXPECT_DOUBLE_EQ(
+      DispatchKernel(KernelType::kCubicSpline, false, h,
+                     [](const auto& kernel) { return kernel.W(0.1); }),
+      CubicSplineKernel(0.1, h));
+}
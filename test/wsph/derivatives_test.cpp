@@ -0,0 +1,330 @@
+#include "wsph/derivatives.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+#include "parstd/simd.hpp"
+#include "utils/types.hpp"
+
+// sets the SimdIsa of the particle loops for the lifetime of the guard
+class SimdIsaGuard {
+ public:
+  explicit SimdIsaGuard(const SimdIsa isa) { SetSimdIsa(isa); }
+  ~SimdIsaGuard() { SetSimdIsa(previous_); }
+
+ private:
+  SimdIsa previous_ = GetSimdIsa();
+};
+
+// a water cube of 8^3 particles above a boundary plate, the fluid particles
+// are moved off the lattice by up to jitter times dr
+static Domain CubeOnPlate(const double jitter = 0.) {
+  const MaterialSettings s = MaterialSettings::Water();
+  std::vector<Vectord> pos, vel, b_pos, b_normal;
+  for (int x = 0; x < 8; ++x) {
+    for (int y = 0; y < 8; ++y) {
+      for (int z = 0; z < 8; ++z) {
+        const int k = pos.size();
+        pos.push_back(s.dr * (Vectord(x, y, z + 1) +
+                              jitter * Vectord(std::sin(k), std::cos(3 * k),
+                                               std::sin(7 * k))));
+        vel.push_back(Vectord(0.1 * x, 0., -0.05 * z));
+      }
+    }
+  }
+  for (int x = -2; x < 10; ++x) {
+    for (int y = -2; y < 10; ++y) {
+      b_pos.push_back(s.dr * Vectord(x, y, 0));
+      b_normal.push_back(Vectord(0., 0., 1.));
+    }
+  }
+  std::vector<Vectord> b_vel(b_pos.size(), Vectord(0.));
+  Particles p(s, std::move(pos), std::move(vel));
+  for (SizeT i = 0; i < p.size(); ++i) {
+    p.dty(i) += 0.1 * (i % 7);
+    p.prs(i) = ComputePressure(p.dty(i), p.ref_density(),
+                               p.pressure_parameter());
+  }
+  return Domain(std::move(p),
+                ParticleBoundary(s, std::move(b_pos), std::move(b_normal),
+                                 std::move(b_vel)));
+}
+
+// The separate sweeps over the fluid and the boundary neighbors, the previous
+// implementation of BasicWeaklyRhs::ComputePP.
+static void ReferencePP(const bool overwrite, const Particles& p,
+                        const Particles& np, const SavedNeighborsD& sn,
+                        Derivative& res) {
+  for (SizeT i = 0; i < p.size(); ++i) {
+    Vectord acc = 0.;
+    double dtyD = 0., dtyDD = 0.;
+    for (const SizeT j : sn.neighbors(i)) {
+      const Vectord rij = p.pos(i) - np.pos(j);
+      const double dist2 = rij * rij, dist = std::sqrt(dist2);
+      const double wg = KernelGradient(dist, p.h());
+      acc -= wg * np.mass() * (p.prs(i) + np.prs(j)) / (p.dty(i) * np.dty(j)) *
+             rij / dist;
+      const Vectord vij = p.vel(i) - np.vel(j);
+      if (vij * rij < 0.) {
+        acc += np.mass() * p.viscosity() * p.sos() *
+               (p.h() * vij * rij / (dist2 + 0.01 * math::tpow<2>(p.h()))) /
+               (0.5 * (p.dty(i) + np.dty(j))) * wg * rij / dist;
+      }
+      dtyD += (p.dty(i) / np.dty(j)) * wg * np.mass() * vij * rij / dist;
+      dtyDD += 2. * 0.1 * (np.dty(j) - p.dty(i)) * rij /
+               (dist2 + 0.01 * math::tpow<2>(p.h())) * (wg * rij) *
+               (np.mass() / np.dty(j));
+    }
+    if (overwrite) {
+      res.dtyD[i] = dtyD + p.h() * p.sos() * dtyDD;
+      res.acc[i] = acc;
+    } else {
+      res.dtyD[i] += dtyD;
+      res.acc[i] += acc;
+    }
+  }
+}
+
+TEST(Derivatives, FusedSweepMatchesSeparateSweeps) {
+  SimdIsaGuard scalar(SimdIsa::kScalar);
+  const Domain d = CubeOnPlate();
+  ASSERT_GT(d.pb.size(), 0);
+  BasicWeaklyRhs rhs(1.5);
+  Derivative res, ref;
+  rhs.Compute(d, res);
+  ref.Resize(d.p.size());
+  ReferencePP(true, d.p, d.p, d.p_p_neighbors, ref);
+  ReferencePP(false, d.p, d.pb, d.p_pb_neighbors, ref);
+
+  ASSERT_EQ(res.size(), ref.size());
+  // the reciprocals of the derived fields change the round-off
+  const double eps = 1.e-12;
+  double courant = 0., max_acc2 = 0.;
+  for (SizeT i = 0; i < d.p.size(); ++i) {
+    for (size_t k = 0; k < 3; ++k) {
+      ASSERT_NEAR(res.acc[i][k], ref.acc[i][k], eps * Length(ref.acc[i]))
+          << "at " << i;
+    }
+    ASSERT_NEAR(res.dtyD[i], ref.dtyD[i], eps * std::abs(ref.dtyD[i]))
+        << "at " << i;
+    for (const SizeT j : d.p_p_neighbors.neighbors(i)) {
+      const Vectord rij = d.p.pos(i) - d.p.pos(j);
+      const double vij_rij = (d.p.vel(i) - d.p.vel(j)) * rij;
+      courant = std::max(
+          courant, std::abs(d.p.h() * vij_rij /
+                            (rij * rij + 0.01 * math::tpow<2>(d.p.h()))));
+    }
+    max_acc2 = std::max(max_acc2, ref.acc[i] * ref.acc[i]);
+  }
+  const double ref_dt =
+      std::min(rhs.cfl() * d.p.h() / (d.p.sos() + courant),
+               rhs.cfl() * std::sqrt(d.p.h()) / std::sqrt(max_acc2));
+  EXPECT_NEAR(rhs.ComputeMaxDt(d, res), ref_dt, eps * ref_dt);
+}
+
+TEST(Derivatives, FusedShiftingMatchesSeparateSweep) {
+  // the fused sweeps are scalar
+  SimdIsaGuard scalar(SimdIsa::kScalar);
+  const Domain d = CubeOnPlate();
+  BasicWeaklyRhs rhs(1.5);
+  Derivative res, ref;
+  DpcShifting shifting, ref_shifting;
+  rhs.Compute(d, res, shifting);
+  rhs.Compute(d, ref);
+  ref_shifting.Compute(d);
+
+  ASSERT_EQ(shifting.collision_term().size(), d.p.size());
+  double max_collision = 0.;
+  for (SizeT i = 0; i < d.p.size(); ++i) {
+    for (size_t k = 0; k < 3; ++k) {
+      ASSERT_EQ(res.acc[i][k], ref.acc[i][k]) << "at " << i;
+      ASSERT_DOUBLE_EQ(shifting.collision_term()[i][k],
+                       ref_shifting.collision_term()[i][k])
+          << "at " << i;
+      ASSERT_DOUBLE_EQ(shifting.repulsive_term()[i][k],
+                       ref_shifting.repulsive_term()[i][k])
+          << "at " << i;
+    }
+    ASSERT_EQ(res.dtyD[i], ref.dtyD[i]) << "at " << i;
+    max_collision =
+        std::max(max_collision, Length(shifting.collision_term()[i]));
+  }
+  // the particles approach each other, so the terms are not trivially zero
+  EXPECT_GT(max_collision, 0.);
+}
+
+TEST(Derivatives, SimdMatchesScalar) {
+  Domain d = CubeOnPlate(0.05);
+  for (const SimdIsa isa : {SimdIsa::kAvx2, SimdIsa::kAvx512}) {
+    if (isa > DetectSimdIsa()) continue;
+    BasicWeaklyRhs rhs(1.5), ref_rhs(1.5);
+    Derivative res, ref;
+    DpcShifting shifting, ref_shifting;
+    ParticleBoundary pb = d.pb, ref_pb = d.pb;
+    {
+      SimdIsaGuard simd(isa);
+      rhs.Compute(d, res);
+      shifting.Compute(d);
+      pb.Interpolate(d.p);
+    }
+    {
+      SimdIsaGuard scalar(SimdIsa::kScalar);
+      ref_rhs.Compute(d, ref);
+      ref_shifting.Compute(d);
+      ref_pb.Interpolate(d.p);
+    }
+    const double eps = 1.e-12;
+    for (SizeT i = 0; i < d.p.size(); ++i) {
+      ASSERT_LT(Length(res.acc[i] - ref.acc[i]), eps * Length(ref.acc[i]))
+          << "at " << i;
+      ASSERT_NEAR(res.dtyD[i], ref.dtyD[i], eps * std::abs(ref.dtyD[i]))
+          << "at " << i;
+      ASSERT_LE(Length(shifting.collision_term()[i] -
+                       ref_shifting.collision_term()[i]),
+                eps * Length(ref_shifting.collision_term()[i]))
+          << "at " << i;
+      ASSERT_LE(Length(shifting.repulsive_term()[i] -
+                       ref_shifting.repulsive_term()[i]),
+                eps * Length(ref_shifting.repulsive_term()[i]))
+          << "at " << i;
+    }
+    EXPECT_NEAR(rhs.ComputeMaxDt(d, res), ref_rhs.ComputeMaxDt(d, ref),
+                eps * ref_rhs.ComputeMaxDt(d, ref));
+    for (SizeT i = 0; i < pb.size(); ++i) {
+      ASSERT_NEAR(pb.dty(i), ref_pb.dty(i), eps * ref_pb.dty(i)) << "at " << i;
+      ASSERT_LE(Length(pb.vel(i) - ref_pb.vel(i)), 1.e-15) << "at " << i;
+    }
+  }
+}
+
+TEST(Derivatives, DerivedFields) {
+  Domain d = CubeOnPlate();
+  BasicWeaklyRhs rhs(1.5);
+  Derivative res;
+  rhs.Compute(d, res);
+  ASSERT_TRUE(d.p_fields.valid());
+  ASSERT_EQ(d.p_fields.size(), d.p.size());
+  ASSERT_EQ(d.pb_fields.size(), d.pb.size());
+  for (SizeT i = 0; i < d.p.size(); ++i) {
+    ASSERT_DOUBLE_EQ(d.p_fields.inv_dty(i) * d.p.dty(i), 1.) << "at " << i;
+    ASSERT_DOUBLE_EQ(d.p_fields.vol(i), d.p.mass() / d.p.dty(i)) << "at " << i;
+  }
+  // the densities change with the step
+  res.Step(1.e-5, Vectord(0., 0., -9.81), d);
+  EXPECT_FALSE(d.p_fields.valid());
+  EXPECT_FALSE(d.pb_fields.valid());
+}
+
+TEST(Derivatives, PairRecordsMatchSeparateArrays) {
+  Domain d = CubeOnPlate(0.05);
+  for (const SimdIsa isa : {SimdIsa::kScalar, DetectSimdIsa()}) {
+    SimdIsaGuard simd(isa);
+    BasicWeaklyRhs rhs(1.5), ref_rhs(1.5);
+    Derivative res, ref;
+    DpcShifting shifting, ref_shifting;
+    ref_rhs.Compute(d, ref);
+    ref_shifting.Compute(d);
+    EXPECT_TRUE(d.p_fields.records().empty());
+    SetPairRecords(true);
+    rhs.Compute(d, res);
+    shifting.Compute(d);
+    SetPairRecords(false);
+    ASSERT_EQ(d.p_fields.records().size(), d.p.size());
+    ASSERT_EQ(d.pb_fields.records().size(), d.pb.size());
+    for (SizeT i = 0; i < d.p.size(); ++i) {
+      const PairRecord& r = d.p_fields.records()[i];
+      ASSERT_EQ(Length(r.pos - d.p.pos(i)), 0.) << "at " << i;
+      ASSERT_EQ(r.prs, d.p.prs(i)) << "at " << i;
+    }
+    // the same pairs in the same order, only read from the records
+    for (SizeT i = 0; i < d.p.size(); ++i) {
+      ASSERT_EQ(Length(res.acc[i] - ref.acc[i]), 0.) << "at " << i;
+      ASSERT_EQ(res.dtyD[i], ref.dtyD[i]) << "at " << i;
+      ASSERT_EQ(Length(shifting.collision_term()[i] -
+                       ref_shifting.collision_term()[i]),
+                0.)
+          << "at " << i;
+      ASSERT_EQ(Length(shifting.repulsive_term()[i] -
+                       ref_shifting.repulsive_term()[i]),
+                0.)
+          << "at " << i;
+    }
+  }
+}
+
+TEST(Derivatives, PairCache) {
+  // off the lattice, where pairs at exactly dr would decide the cutoff of the
+  // shifting by round-off
+  Domain d = CubeOnPlate(0.05);
+  EXPECT_EQ(GetPairCachePolicy(), PairCachePolicy::kOff);
+  d.PlanPairCache(1);
+  EXPECT_FALSE(d.p_p_pairs.enabled());
+  SetPairCachePolicy(PairCachePolicy::kOn);
+  d.PlanPairCache(1);
+  SetPairCachePolicy(PairCachePolicy::kOff);
+  // the scalar and the vectorized RHS fill the cache
+  for (const SimdIsa isa :
+       {SimdIsa::kScalar, SimdIsa::kAvx2, SimdIsa::kAvx512}) {
+    if (isa > DetectSimdIsa()) continue;
+    SCOPED_TRACE(static_cast<int>(isa));
+    SimdIsaGuard guard(isa);
+    BasicWeaklyRhs rhs(1.5);
+    Derivative res;
+    rhs.Compute(d, res);
+    ASSERT_TRUE(d.p_p_pairs.valid());
+    ASSERT_TRUE(d.p_pb_pairs.valid());
+    for (SizeT i = 0; i < d.p.size(); ++i) {
+      const auto neighbors = d.p_p_neighbors.neighbors(i);
+      const auto pairs = std::as_const(d.p_p_pairs).pairs(i);
+      ASSERT_EQ(pairs.size(), neighbors.size());
+      for (SizeT k = 0; k < neighbors.size(); ++k) {
+        const Vectord rij = d.p.pos(i) - d.p.pos(neighbors[k]);
+        ASSERT_NEAR(pairs[k].dist, Length(rij), 1.e-7);
+        ASSERT_NEAR(pairs[k].rij()[2], rij[2], 1.e-7);
+        ASSERT_NEAR(pairs[k].wg, KernelGradient(Length(rij), d.p.h()),
+                    1.e-6 * std::abs(KernelGradient(0., d.p.h())));
+      }
+    }
+
+    // the shifting from the cached geometry differs by the float round-off
+    DpcShifting cached, recomputed;
+    cached.Compute(d);
+    d.p_p_pairs.Invalidate();
+    d.p_pb_pairs.Invalidate();
+    recomputed.Compute(d);
+    for (SizeT i = 0; i < d.p.size(); ++i) {
+      const double scale =
+          1.e-5 * (Length(recomputed.collision_term()[i]) +
+                   Length(recomputed.repulsive_term()[i]) + 1.);
+      ASSERT_LT(Length(cached.collision_term()[i] -
+                       recomputed.collision_term()[i]),
+                scale)
+          << "at " << i;
+      ASSERT_LT(Length(cached.repulsive_term()[i] -
+                       recomputed.repulsive_term()[i]),
+                scale)
+          << "at " << i;
+    }
+  }
+}
+
+TEST(Derivatives, PairCostModel) {
+  PairCostModel model;
+  // plenty of bandwidth, slow arithmetic
+  model.bytes_per_second = 1.e12;
+  model.flops_per_second = 1.e9;
+  EXPECT_FALSE(model.PreferCache(0));
+  EXPECT_TRUE(model.PreferCache(1));
+  // memory bound machine
+  model.bytes_per_second = 1.e9;
+  model.flops_per_second = 1.e13;
+  EXPECT_FALSE(model.PreferCache(1));
+
+  const PairCostModel measured = PairCostModel::Measure();
+  EXPECT_GT(measured.bytes_per_second, 1.e8);
+  EXPECT_GT(measured.flops_per_second, 1.e8);
+}
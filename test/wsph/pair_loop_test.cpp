@@ -0,0 +1,172 @@
+#include "wsph/pair_loop.hpp"
+
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "parstd/prefetch.hpp"
+#include "preprocess/point_shapes.hpp"
+
+namespace {
+struct NeighborSums {
+  SizeT count = 0;
+  double dty_sum = 0.;
+  SizeT position_sum = 0;
+};
+
+// neighbor fields whose density is the index, so the sums over staged copies
+// can be checked against the original indices
+struct IndexFields {
+  explicit IndexFields(const PointCellListD& cell_list)
+      : vel(cell_list.size(), Vectord(0.)),
+        dty(cell_list.size()),
+        prs(cell_list.size(), 1.),
+        inv_dty(cell_list.size(), 1.),
+        vol(cell_list.size(), 1.),
+        fields(cell_list.points().data(), vel.data(), dty.data(), prs.data(),
+               inv_dty.data(), vol.data(), 1.) {
+    for (SizeT j = 0; j < dty.size(); ++j) dty[j] = j;
+  }
+
+  std::vector<Vectord> vel;
+  std::vector<double> dty, prs, inv_dty, vol;
+  PairFields fields;
+};
+
+// records the prefetched neighbors instead of prefetching them
+struct PrefetchRecorder {
+  void Prefetch(const SizeT j) const { prefetched.push_back(j); }
+  mutable std::vector<SizeT> prefetched;
+};
+
+PointCellListD TestCellList(const double cell_size) {
+  return std::get<1>(PointCellListD::Create(
+      cell_size, PointDiscretize::Ellipsoid(cell_size / 2.4, 10. * cell_size,
+                                            Vectord(0.))));
+}
+}  // namespace
+
+TEST(PairLoop, ForEachPair) {
+  const PointCellListD cell_list = TestCellList(0.1);
+  const SavedNeighborsD sn(cell_list);
+  const IndexFields index_fields(cell_list);
+  const SizeT n = cell_list.size();
+  ASSERT_GT(n, 10 * pair_loop_grain);
+  const SimdIsa previous = GetSimdIsa();
+  const size_t previous_tile = GetPairTileBytes();
+  // without tiles and with tiles of 50 particles, whose staged fields take
+  // 80 bytes per neighbor
+  const size_t tile_bytes_50 = 50 * 80 * internal::pair_stage_halo_factor;
+  for (const size_t tile_bytes : {size_t(0), tile_bytes_50}) {
+    SetPairTileBytes(tile_bytes);
+    ASSERT_EQ(PairTileSize(true), tile_bytes ? 50 : 0);
+    for (const SimdIsa isa : {SimdIsa::kScalar, DetectSimdIsa()}) {
+      SetSimdIsa(isa);
+      std::vector<NeighborSums> res(n);
+      std::vector<int> simd_calls(n, 0);
+      ForEachPair<NeighborSums>(
+          n, sn, index_fields.fields,
+          [&](const PairFields& nb, const SizeT, const SizeT j, const SizeT k,
+              NeighborSums& s) {
+            ++s.count;
+            s.dty_sum += nb.dty(j);
+            s.position_sum += k;
+          },
+          [&](const SizeT i, const NeighborSums& s) { res[i] = s; });
+      std::vector<NeighborSums> simd_res(n);
+      ForEachPair<NeighborSums>(
+          n, sn, index_fields.fields,
+          [](const PairFields&, const SizeT, const SizeT, const SizeT,
+             NeighborSums&) {},
+          [&](const SizeT i, const NeighborSums& s) { simd_res[i] = s; },
+          [&](const SimdIsa, const PairFields& nb, const SizeT i,
+              const SavedNeighborsD::ConstRange neighbors) {
+            ++simd_calls[i];
+            NeighborSums s;
+            s.count = neighbors.size();
+            for (const SizeT j : neighbors) s.dty_sum += nb.dty(j);
+            return s;
+          });
+      for (SizeT i = 0; i < n; ++i) {
+        const auto neighbors = sn.neighbors(i);
+        double dty_sum = 0.;
+        for (const SizeT j : neighbors) dty_sum += j;
+        ASSERT_EQ(res[i].count, neighbors.size()) << "at " << i;
+        ASSERT_EQ(res[i].dty_sum, dty_sum) << "at " << i;
+        ASSERT_EQ(res[i].position_sum,
+                  neighbors.size() * (neighbors.size() - 1) / 2)
+            << "at " << i;
+        // the vectorized loop replaces the scalar one unless the isa is
+        // scalar
+        const bool simd = isa != SimdIsa::kScalar;
+        ASSERT_EQ(simd_calls[i], simd ? 1 : 0) << "at " << i;
+        ASSERT_EQ(simd_res[i].count, simd ? neighbors.size() : 0)
+            << "at " << i;
+        ASSERT_EQ(simd_res[i].dty_sum, simd ? dty_sum : 0.) << "at " << i;
+      }
+    }
+  }
+  SetPairTileBytes(previous_tile);
+  SetSimdIsa(previous);
+}
+
+TEST(PairLoop, PairStage) {
+  const PointCellListD cell_list = TestCellList(0.1);
+  const SavedNeighborsD sn(cell_list);
+  const IndexFields index_fields(cell_list);
+  const SizeT b = cell_list.size() / 3, e = b + 40;
+  PairStage stage;
+  ASSERT_TRUE(stage.Stage(sn, index_fields.fields, b, e));
+  const PairFields& staged = stage.fields();
+  ASSERT_TRUE(staged.has_derived());
+  // every staged neighbor once, in the order of the indices
+  for (SizeT j = 1; j < stage.size(); ++j) {
+    ASSERT_LT(staged.dty(j - 1), staged.dty(j));
+  }
+  for (SizeT i = b; i < e; ++i) {
+    const auto neighbors = sn.neighbors(i), local = stage.neighbors(i);
+    ASSERT_EQ(local.size(), neighbors.size());
+    for (SizeT k = 0; k < neighbors.size(); ++k) {
+      ASSERT_LT(local[k], stage.size());
+      EXPECT_EQ(staged.dty(local[k]), neighbors[k]);
+      EXPECT_EQ(staged.pos(local[k])[0], cell_list[neighbors[k]][0]);
+    }
+  }
+}
+
+TEST(PairLoop, SumPairsPrefetch) {
+  const std::vector<SizeT> list = {5, 3, 9, 1, 7};
+  const SavedNeighborsD::ConstRange neighbors(list.data(),
+                                              list.data() + list.size());
+  const int previous = GetPrefetchDistance();
+  for (const int d : {0, 2, 10}) {
+    SetPrefetchDistance(d);
+    const PrefetchRecorder recorder;
+    std::vector<SizeT> visited;
+    const NeighborSums s = SumPairs<NeighborSums>(
+        0, neighbors, recorder,
+        [&](const PrefetchRecorder&, const SizeT, const SizeT j, const SizeT,
+            NeighborSums& sums) {
+          visited.push_back(j);
+          ++sums.count;
+        });
+    EXPECT_EQ(s.count, list.size());
+    EXPECT_EQ(visited, list);
+    // the neighbors d ahead of the pairs, none beyond the end of the list
+    if (d == 2) {
+      EXPECT_EQ(recorder.prefetched, std::vector<SizeT>({9, 1, 7}));
+    } else {
+      EXPECT_TRUE(recorder.prefetched.empty()) << "distance " << d;
+    }
+  }
+  SetPrefetchDistance(previous);
+}
+
+TEST(PairLoop, StoreOrAdd) {
+  Vectord res(1., 2., 3.);
+  StoreOrAdd(false, res, Vectord(1.));
+  EXPECT_EQ(res[2], 4.);
+  StoreOrAdd(true, res, Vectord(1.));
+  EXPECT_EQ(res[0], 1.);
+  EXPECT_EQ(res[2], 1.);
+}
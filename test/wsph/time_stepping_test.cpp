@@ -0,0 +1,116 @@
+#include "wsph/time_stepping.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <vector>
+
+#include "utils/types.hpp"
+
+// a falling water cube of 8^3 particles
+static Domain FallingCube() {
+  const MaterialSettings s = MaterialSettings::Water();
+  std::vector<Vectord> pos, vel;
+  for (int x = 0; x < 8; ++x) {
+    for (int y = 0; y < 8; ++y) {
+      for (int z = 0; z < 8; ++z) {
+        pos.push_back(s.dr * Vectord(x, y, z));
+        vel.push_back(Vectord(0.1 * x, 0., -0.05 * z));
+      }
+    }
+  }
+  return Domain(Particles(s, std::move(pos), std::move(vel)));
+}
+
+// The Verlet step with copies of the initial state, the previous
+// implementation of DualSPHysicsVerletTS::TimeStep.
+static void CopyingVerletTimeStep(const double dt, const Vectord gravity,
+                                  Domain& d) {
+  BasicWeaklyRhs rhs(1.5);
+  Derivative derivative;
+  DpcShifting shifting;
+  double stepped_time = 0.;
+  do {
+    d.pb.Interpolate(d.p);
+    rhs.Compute(d, derivative);
+    const double sub_dt = std::min(rhs.ComputeMaxDt(d, derivative),
+                                   std::max(dt - stepped_time, 1.e-14));
+    const GpuVector<Vectord> init_pos = d.p.pos().points();
+    const VelocityVector init_vel = d.p.vel();
+    const GpuVector<double> init_dty = d.p.dty();
+    derivative.Step(sub_dt / 2., gravity, d);
+    d.pb.Interpolate(d.p);
+    rhs.Compute(d, derivative);
+    for (SizeT i = 0; i < d.p.size(); ++i) {
+      d.p.vel(i) = init_vel[i] + sub_dt * (derivative.acc[i] + gravity);
+      d.SetFluidPos(i,
+                    init_pos[i] + 0.5 * sub_dt * (init_vel[i] + d.p.vel(i)));
+      const double eps = -(derivative.dtyD[i] / d.p.dty(i)) * sub_dt;
+      d.p.dty(i) = init_dty[i] * ((2. - eps) / (2. + eps));
+    }
+    d.Update();
+    shifting.Compute(d);
+    shifting.Apply(sub_dt, d);
+    d.Update();
+    stepped_time += sub_dt;
+  } while (stepped_time < dt);
+}
+
+TEST(TimeStepping, VerletDoubleBufferMatchesCopy) {
+  const Vectord gravity(0., 0., -9.81);
+  Domain d = FallingCube(), ref = FallingCube();
+  DualSPHysicsVerletTS ts(gravity);
+  // several steps, so the particles are reordered in between
+  for (int i = 0; i < 3; ++i) {
+    ts.TimeStep(0.01, d);
+    CopyingVerletTimeStep(0.01, gravity, ref);
+  }
+  ASSERT_EQ(d.p.size(), ref.p.size());
+  for (SizeT i = 0; i < d.p.size(); ++i) {
+    for (size_t k = 0; k < 3; ++k) {
+      ASSERT_NEAR(d.p.pos(i)[k], ref.p.pos(i)[k], 1.e-12) << "at " << i;
+      ASSERT_NEAR(d.p.vel(i)[k], ref.p.vel(i)[k], 1.e-12) << "at " << i;
+    }
+    ASSERT_NEAR(d.p.dty(i), ref.p.dty(i), 1.e-9) << "at " << i;
+  }
+}
+
+TEST(TimeStepping, VerletFusedShifting) {
+  const Vectord gravity(0., 0., -9.81);
+  Domain d = FallingCube(), ref = FallingCube();
+  DualSPHysicsVerletTS ts(gravity, true), ref_ts(gravity);
+  ts.TimeStep(0.01, d);
+  ref_ts.TimeStep(0.01, ref);
+  ASSERT_EQ(d.p.size(), ref.p.size());
+  // the shifting of the corrector state differs from the one of the final
+  // state only by the small motion within the last half step. The particle
+  // order within the cells differs, so the centroids are compared.
+  Vectord centroid = 0., ref_centroid = 0.;
+  for (SizeT i = 0; i < d.p.size(); ++i) {
+    ASSERT_TRUE(std::isfinite(Length(d.p.pos(i)))) << "at " << i;
+    centroid += d.p.pos(i) / d.p.size();
+    ref_centroid += ref.p.pos(i) / ref.p.size();
+  }
+  EXPECT_LT(Length(centroid - ref_centroid),
+            0.01 * MaterialSettings::Water().dr);
+}
+
+TEST(TimeStepping, ReorderKeepsVelocities) {
+  Domain d = FallingCube();
+  const auto vel_of = [](const Vectord& pos) {
+    return Vectord(pos[2], -pos[0], 2. * pos[1]);
+  };
+  // moves the particles across cells, through p.vel(i) of either
+  // VelocityVector layout
+  for (SizeT i = 0; i < d.p.size(); ++i) {
+    d.SetFluidPos(i, Vectord(d.p.pos(i)[1], d.p.pos(i)[2], d.p.pos(i)[0]) +
+                         0.37 * d.p.h());
+    d.p.vel(i) = Vectord(0.);
+    d.p.vel(i) += vel_of(d.p.pos(i));
+  }
+  d.Update();
+  for (SizeT i = 0; i < d.p.size(); ++i) {
+    const Vectord vel = d.p.vel(i);
+    ASSERT_EQ(Length(vel - vel_of(d.p.pos(i))), 0.) << "at " << i;
+  }
+}